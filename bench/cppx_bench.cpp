@@ -0,0 +1,417 @@
+/*
+	Noel Lopes is a Professor at the Polytechnic of Guarda, Portugal
+	and a Researcher at the CISUC - University of Coimbra, Portugal
+	Copyright (C) 2017 Noel de Jesus Mendonça Lopes
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+/// \file cppx_bench.cpp
+/// cppx_bench: measures the performance of cppxgen on reproducible synthetic 
+/// corpora of extended C++ files (.cppx). The Parser, GenerateFileCode and 
+/// GenerateCode (end-to-end) are timed separately.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "code_generator.h"
+#include "console.h"
+#include "parser.h"
+#include "scanner.h"
+
+using namespace cppx;
+using namespace std;
+
+/// Generates the (reproducible) contents of synthetic extended C++ files.
+class CorpusGenerator {
+private:
+	uint64_t state;
+
+	// Deterministic across platforms (unlike the standard distributions)
+	size_t Random(size_t n) {
+		state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+		return static_cast<size_t>(state >> 33) % n;
+	}
+
+	string Identifier(const char * prefix) {
+		return prefix + to_string(Random(100000));
+	}
+
+public:
+	explicit CorpusGenerator(uint64_t seed) : state(seed) {}
+
+	void Class(ostringstream & code, const string & name, size_t members) {
+		code << "/// Class " << name << "\n";
+		code << "class " << name << " : public Base {\n";
+		code << "private:\n";
+		for (size_t m = 0; m < members; ++m) code << "\tint m" << m << ";\n";
+		code << "\npublic:\n";
+		code << "\t" << name << "() : Base()";
+		for (size_t m = 0; m < members; ++m) code << ", m" << m << "(" << Random(1000) << ")";
+		code << " {\n\t}\n\n";
+		code << "\t~" << name << "() {\n\t}\n\n";
+		for (size_t m = 0; m < members; ++m) {
+			code << "\tint Get" << m << "() const {\n\t\treturn m" << m << ";\n\t}\n\n";
+			code << "\tvoid Set" << m << "(int value) {\n\t\tif (value > 0) { m" << m << " = value; }\n\t}\n\n";
+		}
+		code << "\tvoid Declared(int a, double b = 1.0);\n";
+		code << "};\n\n";
+	}
+
+	void Strings(ostringstream & code, size_t number_strings) {
+		code << "const char * Text" << Random(100000) << "(int i) {\n\tswitch (i) {\n";
+		for (size_t s = 0; s < number_strings; ++s) {
+			code << "\t\tcase " << s << ": return \"";
+			size_t length = 40 + Random(200);
+			for (size_t c = 0; c < length; ++c) {
+				switch (Random(24)) {
+					case 0: code << "\\n"; break;
+					case 1: code << "\\\""; break;
+					case 2: code << "\\x4F"; break;
+					case 3: code << "\\101"; break;
+					default: code << static_cast<char>('a' + Random(26)); break;
+				}
+			}
+			code << "\";\n";
+			if (s % 8 == 0) code << "\t\tcase " << s << " + 100000: return R\"raw(" << Identifier("raw ( text ") << ")raw\";\n";
+		}
+		code << "\t}\n\treturn \"\";\n}\n\n";
+	}
+
+	void Comments(ostringstream & code, size_t number_comments) {
+		for (size_t c = 0; c < number_comments; ++c) {
+			if (Random(2) == 0) {
+				code << "/*\n";
+				size_t lines = 1 + Random(20);
+				for (size_t l = 0; l < lines; ++l) code << " * " << Identifier("Comment line with some text ") << " * and more text /\n";
+				code << " */\n";
+			} else {
+				size_t lines = 1 + Random(10);
+				for (size_t l = 0; l < lines; ++l) code << "// " << Identifier("Single line comment ") << "\n";
+			}
+			code << "int value" << c << " = " << Random(1000) << "; // trailing comment\n\n";
+		}
+	}
+
+	void Namespaces(ostringstream & code, size_t depth, size_t classes) {
+		for (size_t d = 0; d < depth; ++d) code << "namespace " << Identifier("ns") << " {\n";
+		for (size_t c = 0; c < classes; ++c) Class(code, Identifier("Nested"), 3);
+		for (size_t d = 0; d < depth; ++d) code << "}\n";
+		code << "\n";
+	}
+
+	void InitializationLists(ostringstream & code, size_t constructors, size_t initializers) {
+		string name = Identifier("Initialized");
+
+		code << "struct " << name << " {\n";
+		for (size_t c = 0; c < constructors; ++c) {
+			code << "\t" << name << "(int a" << c << ") : ";
+			for (size_t i = 0; i < initializers; ++i) {
+				if (i > 0) code << ", ";
+				bool braces = (Random(2) == 0);
+				code << "f" << i << (braces ? "{a" : "(a") << c << " + " << i << (braces ? "}" : ")");
+			}
+			code << " {\n\t}\n\n";
+		}
+		code << "};\n\n";
+	}
+};
+
+/// Synthetic corpus of extended C++ files (.cppx).
+struct Corpus {
+	string name;
+	boost::filesystem::path directory;
+	vector<boost::filesystem::path> files;
+	uintmax_t bytes;
+	size_t tokens;
+
+	Corpus(const string & name, const boost::filesystem::path & base_dir) : name(name), directory(base_dir / name), bytes(0), tokens(0) {
+		boost::filesystem::create_directories(directory);
+	}
+
+	void AddFile(const string & filename, const string & code) {
+		boost::filesystem::path path = directory / (filename + ".cppx");
+		ofstream(path.string(), ofstream::binary) << code;
+
+		files.push_back(path);
+		bytes += code.size();
+	}
+};
+
+vector<Corpus> GenerateCorpora(const boost::filesystem::path & base_dir, size_t scale) {
+	CorpusGenerator generator(2017);
+	vector<Corpus> corpora;
+
+	corpora.push_back(Corpus("tiny_files", base_dir));
+	for (size_t f = 0; f < 2000 * scale; ++f) {
+		ostringstream code;
+		generator.Class(code, "Tiny" + to_string(f), 1);
+		corpora.back().AddFile("tiny" + to_string(f), code.str());
+	}
+
+	corpora.push_back(Corpus("huge_files", base_dir));
+	for (size_t f = 0; f < 2; ++f) {
+		ostringstream code;
+		for (size_t c = 0; c < 2500 * scale; ++c) {
+			generator.Class(code, "Huge" + to_string(c), 8);
+			if (c % 10 == 0) generator.Strings(code, 4);
+			if (c % 10 == 5) generator.Comments(code, 4);
+		}
+		corpora.back().AddFile("huge" + to_string(f), code.str());
+	}
+
+	corpora.push_back(Corpus("strings", base_dir));
+	for (size_t f = 0; f < 50 * scale; ++f) {
+		ostringstream code;
+		generator.Strings(code, 500);
+		corpora.back().AddFile("strings" + to_string(f), code.str());
+	}
+
+	corpora.push_back(Corpus("comments", base_dir));
+	for (size_t f = 0; f < 50 * scale; ++f) {
+		ostringstream code;
+		generator.Comments(code, 200);
+		corpora.back().AddFile("comments" + to_string(f), code.str());
+	}
+
+	corpora.push_back(Corpus("deep_namespaces", base_dir));
+	for (size_t f = 0; f < 200 * scale; ++f) {
+		ostringstream code;
+		generator.Namespaces(code, 32, 4);
+		corpora.back().AddFile("namespaces" + to_string(f), code.str());
+	}
+
+	corpora.push_back(Corpus("initialization_lists", base_dir));
+	for (size_t f = 0; f < 200 * scale; ++f) {
+		ostringstream code;
+		generator.InitializationLists(code, 20, 50);
+		corpora.back().AddFile("initialization_lists" + to_string(f), code.str());
+	}
+
+	return corpora;
+}
+
+/// Stream buffer that discards everything (used to silence the console while timing).
+class NullBuffer : public streambuf {
+protected:
+	int overflow(int c) override {
+		return c;
+	}
+
+	streamsize xsputn(const char *, streamsize n) override {
+		return n;
+	}
+};
+
+/// Silences std::cout and std::cerr (and therefore the Console) while it exists.
+class SilentConsole {
+private:
+	NullBuffer null_buffer;
+	streambuf * cout_buffer;
+	streambuf * cerr_buffer;
+
+public:
+	SilentConsole() : cout_buffer(cout.rdbuf(&null_buffer)), cerr_buffer(cerr.rdbuf(&null_buffer)) {}
+
+	~SilentConsole() {
+		cout.rdbuf(cout_buffer);
+		cerr.rdbuf(cerr_buffer);
+	}
+};
+
+/// Returns the best (minimum) time, in seconds, of several repetitions of a function. 
+double BestTime(size_t repetitions, const function<void()> & f) {
+	double best = 0;
+
+	for (size_t r = 0; r < repetitions; ++r) {
+		auto start = chrono::steady_clock::now();
+		f();
+		double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+		if (r == 0 || seconds < best) best = seconds;
+	}
+
+	return best;
+}
+
+struct Result {
+	string corpus;
+	string phase;
+	size_t files;
+	uintmax_t bytes;
+	size_t tokens;
+	double seconds;
+
+	double MegabytesPerSecond() const { return (seconds > 0) ? bytes / (1024.0 * 1024.0) / seconds : 0; }
+	double TokensPerSecond() const { return (seconds > 0) ? tokens / seconds : 0; }
+	double FilesPerSecond() const { return (seconds > 0) ? files / seconds : 0; }
+};
+
+vector<Result> Benchmark(Corpus & corpus, size_t repetitions, size_t number_threads) {
+	vector<Result> results;
+
+	// The storage of the contexts is reused across the files, as cppxgen does for the files processed by each thread
+	Parser::Context parser_context;
+	GenerationContext generation_context;
+
+	double seconds = BestTime(repetitions, [&] {
+		corpus.tokens = 0;
+
+		for (const auto & f : corpus.files) {
+			Parser parser(f, parser_context);
+			corpus.tokens += parser.CodeBlocks().size();
+		}
+	});
+
+	results.push_back(Result { corpus.name, "parser", corpus.files.size(), corpus.bytes, corpus.tokens, seconds });
+
+	SilentConsole silent_console;
+
+	seconds = BestTime(repetitions, [&] {
+		for (const auto & f : corpus.files) GenerateFileCode(f, generation_context);
+	});
+
+	results.push_back(Result { corpus.name, "generate_file_code", corpus.files.size(), corpus.bytes, corpus.tokens, seconds });
+
+	GenerationOptions options;
+	options.number_threads = number_threads;
+	options.use_cache = false;
+
+	seconds = BestTime(repetitions, [&] {
+		GenerateCode(corpus.directory.string().c_str(), options);
+	});
+
+	results.push_back(Result { corpus.name, "generate_code", corpus.files.size(), corpus.bytes, corpus.tokens, seconds });
+
+	return results;
+}
+
+void PrintText(const vector<Result> & results) {
+	cout << left << setw(22) << "corpus" << setw(20) << "phase" << right << setw(8) << "files" << setw(12) << "MB" << setw(12) << "seconds" << setw(12) << "MB/s" << setw(14) << "tokens/s" << setw(12) << "files/s" << endl;
+
+	for (const auto & r : results) {
+		cout << left << setw(22) << r.corpus << setw(20) << r.phase << right << setw(8) << r.files;
+		cout << fixed << setprecision(2) << setw(12) << r.bytes / (1024.0 * 1024.0) << setprecision(4) << setw(12) << r.seconds;
+		cout << setprecision(1) << setw(12) << r.MegabytesPerSecond() << setprecision(0) << setw(14) << r.TokensPerSecond() << setw(12) << r.FilesPerSecond() << endl;
+	}
+}
+
+void PrintJson(ostream & os, const vector<Result> & results, size_t scale, size_t repetitions, size_t number_threads) {
+	os << "{\n";
+	os << "\t\"version\": \"" << CPPX_VERSION_STRING << "\",\n";
+	os << "\t\"instruction_set\": \"" << Scanner::InstructionSet() << "\",\n";
+	os << "\t\"scale\": " << scale << ",\n";
+	os << "\t\"repetitions\": " << repetitions << ",\n";
+	os << "\t\"threads\": " << number_threads << ",\n";
+	os << "\t\"results\": [\n";
+
+	for (size_t i = 0; i < results.size(); ++i) {
+		const Result & r = results[i];
+
+		os << setprecision(9) << "\t\t{ \"corpus\": \"" << r.corpus << "\", \"phase\": \"" << r.phase << "\", \"files\": " << r.files << ", \"bytes\": " << r.bytes << ", \"tokens\": " << r.tokens;
+		os << ", \"seconds\": " << r.seconds << ", \"mb_per_second\": " << r.MegabytesPerSecond() << ", \"tokens_per_second\": " << r.TokensPerSecond() << ", \"files_per_second\": " << r.FilesPerSecond() << " }";
+		os << ((i + 1 < results.size()) ? ",\n" : "\n");
+	}
+
+	os << "\t]\n";
+	os << "}\n";
+}
+
+/// Main entry point for cppx_bench
+/// Usage: cppx_bench [--json[=file]] [--scale N] [--repetitions N] [-j threads] [--dir directory]
+int main(int argc, char * argv[]) {
+	size_t scale = 1;
+	size_t repetitions = 3;
+	size_t number_threads = max(thread::hardware_concurrency(), 1u);
+	bool json = false;
+	string json_filename;
+	boost::filesystem::path directory;
+
+	for (int a = 1; a < argc; ++a) {
+		string argument = argv[a];
+
+		auto Value = [&] () -> size_t {
+			size_t value = (a + 1 < argc) ? strtoul(argv[++a], nullptr, 10) : 0;
+
+			if (value == 0) {
+				Console::ErrorStream() << "Invalid value for " << argument << endl;
+				exit(1);
+			}
+
+			return value;
+		};
+
+		if (argument == "--json") {
+			json = true;
+		} else if (argument.compare(0, 7, "--json=") == 0) {
+			json = true;
+			json_filename = argument.substr(7);
+		} else if (argument == "--scale") {
+			scale = Value();
+		} else if (argument == "--repetitions") {
+			repetitions = Value();
+		} else if (argument == "-j") {
+			number_threads = Value();
+		} else if (argument == "--dir" && a + 1 < argc) {
+			directory = argv[++a];
+		} else {
+			Console::ErrorStream() << "Usage: cppx_bench [--json[=file]] [--scale N] [--repetitions N] [-j threads] [--dir directory]" << endl;
+			return 1;
+		}
+	}
+
+	bool remove_directory = directory.empty();
+	if (remove_directory) directory = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("cppx_bench-%%%%-%%%%");
+
+	if (!json) Console::OutputStream() << "Generating corpora in " << directory << endl;
+
+	vector<Corpus> corpora = GenerateCorpora(directory, scale);
+	vector<Result> results;
+
+	for (auto & corpus : corpora) {
+		if (!json) Console::OutputStream() << "Benchmarking " << corpus.name << " (" << corpus.files.size() << " files, " << corpus.bytes << " bytes)" << endl;
+
+		auto corpus_results = Benchmark(corpus, repetitions, number_threads);
+		results.insert(results.end(), corpus_results.begin(), corpus_results.end());
+	}
+
+	if (remove_directory) {
+		boost::system::error_code error;
+		boost::filesystem::remove_all(directory, error);
+	}
+
+	if (!json) {
+		Console::OutputStream() << endl;
+		PrintText(results);
+	} else if (json_filename.empty()) {
+		PrintJson(cout, results, scale, repetitions, number_threads);
+	} else {
+		ofstream file(json_filename);
+		PrintJson(file, results, scale, repetitions, number_threads);
+	}
+
+	return 0;
+}
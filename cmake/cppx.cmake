@@ -0,0 +1,140 @@
+#=================================================
+#
+# Noel Lopes is a Professor at the Polytechnic of Guarda, Portugal
+# and a Researcher at the CISUC - University of Coimbra, Portugal
+# Copyright (C) 2017, 2018 Noel de Jesus Mendonça Lopes
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#	http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#=================================================
+
+include(CMakeParseArguments)
+
+#-------------------------------------------------
+# cppx_generate(<target> [OUTPUT_DIRECTORY <directory>] [FORWARD_DECLARATIONS] <file.cppx> ...)
+#
+# Generates the standard C++ files (.h and .cpp) of each extended C++ file 
+# (.cppx) with a separate custom command, which only runs when the .cppx 
+# file (or cppxgen) changes. Thus the build system generates the files in 
+# parallel and only when they are stale. The generated files are added to 
+# the sources of <target>, which depends on a <target>_cppx target that 
+# generates them.
+#
+# OUTPUT_DIRECTORY: directory of the generated files (default 
+# ${CMAKE_CURRENT_BINARY_DIR}/cppx), which is added to the include directories 
+# of <target>. The .cppx files keep their location relative to 
+# ${CMAKE_CURRENT_SOURCE_DIR}.
+#
+# FORWARD_DECLARATIONS: also generate a header with the forward declarations 
+# (<name>_fwd.h) of each file.
+#
+# The cppxgen target is used when it exists (e.g. when cppx is added with
+# add_subdirectory), otherwise the cppxgen executable is searched for.
+#-------------------------------------------------
+function(cppx_generate target)
+    cmake_parse_arguments(CPPX "FORWARD_DECLARATIONS" "OUTPUT_DIRECTORY" "" ${ARGN})
+
+    set(generator_options -j 1)
+
+    if (CPPX_FORWARD_DECLARATIONS)
+        list(APPEND generator_options --fwd)
+    endif()
+
+    if (NOT CPPX_OUTPUT_DIRECTORY)
+        set(CPPX_OUTPUT_DIRECTORY "${CMAKE_CURRENT_BINARY_DIR}/cppx")
+    endif()
+
+    if (NOT IS_ABSOLUTE "${CPPX_OUTPUT_DIRECTORY}")
+        set(CPPX_OUTPUT_DIRECTORY "${CMAKE_CURRENT_BINARY_DIR}/${CPPX_OUTPUT_DIRECTORY}")
+    endif()
+
+    if (TARGET cppxgen)
+        set(generator cppxgen)
+    else()
+        find_program(CPPXGEN_EXECUTABLE cppxgen)
+
+        if (NOT CPPXGEN_EXECUTABLE)
+            message(FATAL_ERROR "Could not find cppxgen. Please set CPPXGEN_EXECUTABLE.")
+        endif()
+
+        set(generator "${CPPXGEN_EXECUTABLE}")
+    endif()
+
+    set(generated_files)
+    set(stamps)
+
+    foreach(cppx_file ${CPPX_UNPARSED_ARGUMENTS})
+        get_filename_component(cppx_file "${cppx_file}" ABSOLUTE)
+        get_filename_component(name "${cppx_file}" NAME_WE)
+        get_filename_component(cppx_dir "${cppx_file}" DIRECTORY)
+
+        file(RELATIVE_PATH relative_dir "${CMAKE_CURRENT_SOURCE_DIR}" "${cppx_dir}")
+
+        if (relative_dir MATCHES "^\\.\\.")
+            set(output_dir "${CPPX_OUTPUT_DIRECTORY}")
+        else()
+            set(output_dir "${CPPX_OUTPUT_DIRECTORY}/${relative_dir}")
+        endif()
+
+        set(outputs "${output_dir}/${name}.h" "${output_dir}/${name}.cpp")
+
+        if (CPPX_FORWARD_DECLARATIONS)
+            list(APPEND outputs "${output_dir}/${name}_fwd.h")
+        endif()
+
+        # cppxgen keeps the outputs untouched when their contents do not change. The stamp 
+        # records when the file was generated and (with CMake 3.2 or greater) the outputs 
+        # are byproducts, so that Ninja does not rebuild what depends on unchanged outputs.
+        set(stamp "${output_dir}/${name}.cppx.stamp")
+
+        if (CMAKE_VERSION VERSION_LESS 3.2)
+            set(stamp_outputs OUTPUT "${stamp}" ${outputs})
+        else()
+            set(stamp_outputs OUTPUT "${stamp}" BYPRODUCTS ${outputs})
+        endif()
+
+        add_custom_command(
+            ${stamp_outputs}
+            COMMAND ${generator} ${generator_options} "${cppx_file}" -o "${output_dir}"
+            COMMAND ${CMAKE_COMMAND} -E touch "${stamp}"
+            DEPENDS "${cppx_file}" ${generator}
+            COMMENT "Generating C++ code from ${cppx_file}"
+            VERBATIM
+        )
+
+        list(APPEND generated_files ${outputs})
+        list(APPEND stamps "${stamp}")
+    endforeach()
+
+    # The files are generated by a separate target, so that they exist before any source 
+    # of <target> (which may include the generated headers) is compiled
+    get_property(number_calls TARGET ${target} PROPERTY CPPX_NUMBER_GENERATE_CALLS)
+
+    if (NOT number_calls)
+        set(number_calls 0)
+    endif()
+
+    math(EXPR number_calls "${number_calls} + 1")
+    set_property(TARGET ${target} PROPERTY CPPX_NUMBER_GENERATE_CALLS ${number_calls})
+
+    set(generate_target "${target}_cppx")
+
+    if (number_calls GREATER 1)
+        set(generate_target "${generate_target}_${number_calls}")
+    endif()
+
+    add_custom_target(${generate_target} DEPENDS ${stamps})
+    add_dependencies(${target} ${generate_target})
+
+    set_property(TARGET ${target} APPEND PROPERTY SOURCES ${generated_files})
+    target_include_directories(${target} PUBLIC "${CPPX_OUTPUT_DIRECTORY}")
+endfunction()
@@ -0,0 +1,1004 @@
+/*
+	Noel Lopes is a Professor at the Polytechnic of Guarda, Portugal
+	and a Researcher at the CISUC - University of Coimbra, Portugal
+	Copyright (C) 2017 Noel de Jesus Mendonça Lopes
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "code_generator.h"
+#include "console.h"
+#include "declarations.h"
+#include "dependencies.h"
+#include "file_discovery.h"
+#include "file_watcher.h"
+#include "hash.h"
+#include "memory_budget.h"
+#include "output_file.h"
+#include "parser.h"
+#include "statistics.h"
+#include "unity_build.h"
+#include "work_stealing_pool.h"
+
+using namespace std;
+
+namespace cppx {
+	vector<boost::filesystem::path> GetFilesToProcess(const char * base_dir, size_t number_threads, const vector<string> & exclude) {
+		return FindFiles(base_dir, ".cppx", ExclusionList(base_dir, exclude), number_threads);
+	}
+
+	// Namespaces (with a body) that precede the first class, struct or enumeration definition (e.g. "A_B_")
+	std::string CodeGuardNamespaces(const Declarations & declarations) {
+		std::string result;
+
+		const auto & code_blocks = declarations.CodeBlocks();
+
+		for (const auto & declaration : declarations.All()) {
+			if (!declaration.has_body) continue;
+
+			if (declaration.type == Declarations::Declaration::Type::namespace_declaration) {
+				for (size_t b = declaration.begin + 1; b < declaration.body; ++b) {
+					if (code_blocks.Type(b) == Parser::CodeBlock::Type::identifier) {
+						result.append(code_blocks.View(b).data(), code_blocks.View(b).size());
+						result += '_';
+					}
+				}
+			} else if (declaration.IsContainer()) {
+				break;
+			}
+		}
+
+		return result;
+	}
+
+	std::string CodeGuardIdentifier(const boost::filesystem::path & path, const Declarations & declarations) {
+		std::string result = CodeGuardNamespaces(declarations);
+
+		result += path.stem().string() + "_H";
+
+		for (auto & c : result) c = toupper(c);
+
+		return result;
+	}
+
+	// Returns the code in [begin, end), with each sequence of white spaces replaced by a single space (and trimmed)
+	std::string NormalizedCode(const char * begin, const char * end) {
+		std::string result;
+
+		for (const char * c = begin; c < end; ++c) {
+			if (Scanner::IsWhiteSpace(*c)) {
+				if (!result.empty() && result.back() != ' ') result += ' ';
+			} else {
+				result += *c;
+			}
+		}
+
+		if (!result.empty() && result.back() == ' ') result.pop_back();
+
+		return result;
+	}
+
+	// Finds the declarations of the forward declarations header: the classes, structs and enumerations (with a fixed 
+	// underlying type) declared in namespace scope (templates and the declarations within anonymous namespaces are not included)
+	class ForwardDeclarationsEmitter : public DeclarationEmitter {
+	public:
+		struct Declaration {
+			std::vector<std::string> namespaces;
+			std::string code;
+		};
+
+		std::vector<Declaration> declarations;
+
+	private:
+		typedef Declarations::Declaration::Type Type;
+
+		std::vector<std::string> namespaces;
+		std::vector<bool> anonymous; // whether each of the namespaces is anonymous
+		size_t anonymous_namespaces = 0;
+
+		static bool EndsWith(const Declarations & tree, size_t block, char c) {
+			return block != Declarations::NONE && tree.CodeBlocks().View(block).back() == c;
+		}
+
+	public:
+		bool Enter(const Declarations & tree, const Declarations::Declaration & declaration) override {
+			if (!declaration.has_body || !declaration.IsContainer()) return false;
+
+			const auto & code_blocks = tree.CodeBlocks();
+			const Parser::CodeBlock keyword = code_blocks[declaration.begin];
+			const Parser::CodeBlock body = code_blocks[declaration.body];
+
+			if (declaration.type == Type::namespace_declaration) {
+				std::string code = NormalizedCode(keyword.begin, body.begin);
+				bool is_inline = (declaration.previous != Declarations::NONE && code_blocks.View(declaration.previous) == "inline");
+
+				if (declaration.name.empty()) anonymous_namespaces++;
+				namespaces.push_back((is_inline) ? "inline " + code : code);
+				anonymous.push_back(declaration.name.empty());
+
+				return true;
+			}
+
+			// class and struct may also be used in template parameters (template <class T>)
+			bool is_template = EndsWith(tree, declaration.previous, '>') || (declaration.type != Type::enumeration && (EndsWith(tree, declaration.previous, '<') || EndsWith(tree, declaration.previous, ',')));
+
+			if (is_template || anonymous_namespaces > 0 || declaration.name.empty()) return false;
+
+			std::string code;
+
+			if (declaration.type == Type::enumeration) {
+				// Only enumerations with a fixed underlying type (enum class or enum E : type) can be forward declared
+				bool has_underlying_type = false;
+
+				for (size_t b = declaration.begin + 1; b < declaration.body; ++b) {
+					if (code_blocks.Type(b) == Parser::CodeBlock::Type::other && code_blocks.View(b).front() == ':') has_underlying_type = true;
+				}
+
+				code = NormalizedCode(keyword.begin, body.begin);
+
+				if (code.compare(0, 10, "enum class") != 0 && code.compare(0, 11, "enum struct") != 0 && !has_underlying_type) return false;
+			} else {
+				code.assign(keyword.begin, keyword.Size()).append(" ").append(declaration.name.data(), declaration.name.size());
+			}
+
+			declarations.push_back(Declaration { namespaces, code + ';' });
+
+			return false;
+		}
+
+		void Leave(const Declarations & tree, const Declarations::Declaration & declaration) override {
+			if (anonymous.back()) anonymous_namespaces--;
+
+			namespaces.pop_back();
+			anonymous.pop_back();
+		}
+	};
+
+	// Writes the forward declarations header (see ForwardDeclarationsEmitter)
+	void WriteForwardDeclarations(const Declarations & tree, const std::string & include_guard, std::string & output) {
+		ForwardDeclarationsEmitter emitter;
+		tree.Emit(emitter);
+
+		const auto & declarations = emitter.declarations;
+
+		output.append("#ifndef ").append(include_guard).append("\n");
+		output.append("#define ").append(include_guard).append("\n\n");
+
+		std::vector<std::string> open_namespaces;
+
+		auto CloseNamespaces = [&] (size_t number_kept) {
+			while (open_namespaces.size() > number_kept) {
+				open_namespaces.pop_back();
+				output.append(open_namespaces.size(), '\t').append("}\n");
+			}
+		};
+
+		for (const auto & declaration : declarations) {
+			size_t common = 0;
+			while (common < open_namespaces.size() && common < declaration.namespaces.size() && open_namespaces[common] == declaration.namespaces[common]) common++;
+
+			CloseNamespaces(common);
+
+			for (size_t n = common; n < declaration.namespaces.size(); ++n) {
+				output.append(open_namespaces.size(), '\t').append(declaration.namespaces[n]).append(" {\n");
+				open_namespaces.push_back(declaration.namespaces[n]);
+			}
+
+			output.append(open_namespaces.size(), '\t').append(declaration.code).append("\n");
+		}
+
+		CloseNamespaces(0);
+
+		output.append("\n#endif // ").append(include_guard).append("\n");
+	}
+
+	// Replaces the extension of filename, storing the result in output (without allocating memory, once it is large enough)
+	void ReplaceExtension(std::string & output, const boost::filesystem::path & filename, const char * extension) {
+		const std::string & name = filename.string();
+
+		output.assign(name, 0, name.size() - filename.extension().size());
+		output.append(extension);
+	}
+
+	// Stores in output the name of the forward declarations header corresponding to a header (<name>.h -> <name>_fwd.h)
+	void ForwardHeaderFilename(std::string & output, const std::string & header_filename) {
+		output.assign(header_filename, 0, header_filename.size() - 2);
+		output.append("_fwd.h");
+	}
+
+	/// Generates the contents of the header (.h) and source (.cpp) files in memory,
+	/// each one in a single contiguous buffer (provided by a GenerationContext).
+	/// The files are only written (by Save) when their contents change.
+	class CodeWriter {
+	private:
+		// Extra space reserved for the code added to the outputs (include guards, scopes, ...)
+		static constexpr size_t EXTRA_OUTPUT_CAPACITY = 1024;
+
+		const std::string & cpp_filename;
+		const std::string & header_filename;
+
+		std::string & cpp_file;
+		std::string & header_file;
+
+		std::string & buffer;
+
+		bool output_dir_given;
+
+		bool forward_declarations;
+		std::string & forward_header_filename;
+		std::string & forward_header_file;
+
+		const boost::filesystem::path & source; // .cppx file
+		OutputWriter * output_writer;
+
+		// The contents are taken by the output writer (if any), which reports its errors on its own (see OutputWriter::Finish)
+		void SaveOutput(const std::string & filename, std::string & contents) {
+			if (output_writer != nullptr) {
+				output_writer->Write(filename, contents, &source);
+				return;
+			}
+
+			bool written = WriteFileIfChanged(filename, contents);
+
+			Statistics::Add(Statistics::Counter::bytes_out, contents.size());
+			Statistics::Add(written ? Statistics::Counter::outputs_written : Statistics::Counter::outputs_unchanged);
+		}
+
+	public:
+		/// Creates a code writer, which generates the code of \a filename in the buffers of the context.
+		/// \param filename Extended C++ file (.cppx) being processed.
+		/// \param output_dir Directory of the generated files (if empty, they are generated next to \a filename).
+		/// \param code_size Size of the extended C++ code, used to estimate the size of the outputs.
+		/// \param context Context that provides the buffers for the filenames and the outputs.
+		CodeWriter(const boost::filesystem::path & filename, const boost::filesystem::path & output_dir, size_t code_size, GenerationContext & context) :
+			cpp_filename(context.cpp_filename),
+			header_filename(context.header_filename),
+			cpp_file(context.cpp_file),
+			header_file(context.header_file),
+			buffer(context.buffer),
+			output_dir_given(!output_dir.empty()),
+			forward_declarations(context.forward_declarations),
+			forward_header_filename(context.forward_header_filename),
+			forward_header_file(context.forward_header_file),
+			source(filename),
+			output_writer(context.output_writer) {
+			if (output_dir_given) {
+				boost::filesystem::path output = output_dir / filename.filename();
+
+				ReplaceExtension(context.cpp_filename, output, ".cpp");
+				ReplaceExtension(context.header_filename, output, ".h");
+			} else {
+				ReplaceExtension(context.cpp_filename, filename, ".cpp");
+				ReplaceExtension(context.header_filename, filename, ".h");
+			}
+
+			cpp_file.clear();
+			header_file.clear();
+			buffer.clear();
+
+			if (forward_declarations) {
+				ForwardHeaderFilename(forward_header_filename, header_filename);
+				forward_header_file.clear();
+			}
+
+			cpp_file.reserve(code_size + EXTRA_OUTPUT_CAPACITY);
+			header_file.reserve(code_size + EXTRA_OUTPUT_CAPACITY);
+		}
+
+		/// Returns the header, as included by the source file. When an output directory is 
+		/// given, both files are in that directory, so the header is included by its name.
+		boost::string_ref IncludedHeader() const {
+			boost::string_ref header(header_filename);
+
+			if (output_dir_given) {
+				size_t separator = header.find_last_of("/\\");
+				if (separator != boost::string_ref::npos) header.remove_prefix(separator + 1);
+			}
+
+			return header;
+		}
+
+		/// Returns whether the forward declarations header (<name>_fwd.h) is also generated (see GenerationContext).
+		bool ForwardDeclarations() const {
+			return forward_declarations;
+		}
+
+		std::string & ForwardHeaderFile() {
+			return forward_header_file;
+		}
+
+		CodeWriter(const CodeWriter &) = delete;
+		CodeWriter & operator = (const CodeWriter &) = delete;
+
+		void AppendToBuffer(boost::string_ref s) {
+			buffer.append(s.data(), s.size());
+		}
+
+		void WriteBufferToHeader() {
+			if (buffer.size() > 0) {
+				header_file += buffer;
+				buffer.clear();
+			}
+		}
+
+		void WriteBufferToCpp() {
+			if (buffer.size() > 0) {
+				cpp_file += buffer;
+				buffer.clear();
+			}
+		}
+
+		void WriteBufferToBoth() {
+			if (buffer.size() > 0) {
+				header_file += buffer;
+				cpp_file += buffer;
+				buffer.clear();
+			}
+		}
+
+		void WriteToHeader(boost::string_ref s) {
+			WriteBufferToHeader();
+			header_file.append(s.data(), s.size());
+		}
+
+		void WriteToCpp(boost::string_ref s) {
+			WriteBufferToCpp();
+			cpp_file.append(s.data(), s.size());
+		}
+
+
+		void WriteToBoth(boost::string_ref s) {
+			WriteBufferToBoth();
+			header_file.append(s.data(), s.size());
+			cpp_file.append(s.data(), s.size());
+		}
+
+		std::string & HeaderFile() {
+			WriteBufferToHeader();
+			return header_file;
+		}
+
+		std::string & CppFile() {
+			WriteBufferToCpp();
+			return cpp_file;
+		}
+
+		/// Writes the header and the source files (and the forward declarations header), unless they are already up to date.
+		/// When the context has an output writer, the files are queued to be written by it (and their contents are taken).
+		/// \param header Signature of the header file written.
+		/// \param cpp Signature of the source file written.
+		/// \throws boost::filesystem::filesystem_error if a file could not be written.
+		void Save(FileSignature & header, FileSignature & cpp) {
+			WriteBufferToHeader();
+
+			header = FileSignature(header_file);
+			cpp = FileSignature(cpp_file);
+
+			Statistics::Timer timer(Statistics::Phase::write);
+
+			SaveOutput(header_filename, header_file);
+			SaveOutput(cpp_filename, cpp_file);
+
+			if (forward_declarations) SaveOutput(forward_header_filename, forward_header_file);
+		}
+	};
+
+	// Generates the code of the header and source files: the function definitions are moved  
+	// to the source file (prefixed by their scope) and replaced by their declarations in the header
+	class SourceEmitter : public DeclarationEmitter {
+	private:
+		typedef Parser::CodeBlock::Type BlockType;
+
+		CodeWriter & code_writer;
+
+		// Qualified name of the current scope (e.g. "a::B::"), kept up to date as the 
+		// containers are entered and left, which prefixes the functions defined in the cpp file
+		std::string & scope;
+
+		size_t first_block; // code blocks before this one are not emitted (see WriteCode)
+
+	public:
+		SourceEmitter(CodeWriter & code_writer, std::string & scope, size_t first_block) : code_writer(code_writer), scope(scope), first_block(first_block) {
+			scope.clear();
+		}
+
+		void Code(const Declarations & declarations, size_t begin, size_t end) override {
+			const auto & code_blocks = declarations.CodeBlocks();
+
+			for (size_t b = std::max(begin, first_block); b < end; ++b) {
+				switch (code_blocks.Type(b)) {
+					case BlockType::directive:
+					case BlockType::access_modifier:
+					case BlockType::statement_terminator:
+					case BlockType::begin_group:
+					case BlockType::end_group:
+						code_writer.WriteToHeader(code_blocks.View(b));
+						break;
+
+					default:
+						code_writer.AppendToBuffer(code_blocks.View(b));
+						break;
+				}
+			}
+		}
+
+		bool Enter(const Declarations & declarations, const Declarations::Declaration & declaration) override {
+			if (declaration.IsFunction()) {
+				if (declaration.has_body) {
+					code_writer.WriteBufferToBoth();
+					code_writer.WriteToCpp(scope);
+					code_writer.WriteToBoth(declarations.View(declaration.begin, declaration.body));
+
+					code_writer.HeaderFile() += ';';
+
+					code_writer.WriteToCpp(declarations.View(declaration.body, declaration.end));
+				} else {
+					code_writer.WriteToHeader(declarations.View(declaration.begin, declaration.end));
+				}
+
+				return false;
+			}
+
+			if (declaration.type == Declarations::Declaration::Type::group) {
+				code_writer.WriteToHeader(declarations.CodeBlocks().View(declaration.begin));
+			} else {
+				code_writer.AppendToBuffer(declarations.View(declaration.begin, declaration.body + 1));
+				code_writer.WriteBufferToHeader();
+
+				if (declaration.has_body && !declaration.name.empty()) scope.append(declaration.name.data(), declaration.name.size()).append("::");
+			}
+
+			return true;
+		}
+
+		void Leave(const Declarations & declarations, const Declarations::Declaration & declaration) override {
+			if (!declaration.has_body) return;
+
+			if (declaration.complete) code_writer.WriteToHeader(declarations.CodeBlocks().View(declaration.end - 1));
+
+			if (declaration.IsContainer() && !declaration.name.empty()) scope.resize(scope.size() - declaration.name.size() - 2);
+		}
+	};
+
+	// Generates the code of the header and source files (in the buffers of the code writer)
+	void WriteCode(const boost::filesystem::path & filename, const Declarations & declarations, CodeWriter & code_writer, GenerationContext & context) {
+		const auto & code_blocks = declarations.CodeBlocks();
+		size_t first_block = 0;
+
+		// The leading comment is written to both files, without the line terminator that follows it
+		if (code_blocks.Type(first_block) == Parser::CodeBlock::Type::comment) code_writer.WriteToBoth(code_blocks.View(first_block++));
+		if (first_block < code_blocks.size() && code_blocks.Type(first_block) == Parser::CodeBlock::Type::empty) first_block++;
+
+		std::string include_guard = CodeGuardIdentifier(filename, declarations);
+
+		code_writer.HeaderFile().append("#ifndef ").append(include_guard).append("\n");
+		code_writer.HeaderFile().append("#define ").append(include_guard).append("\n\n");
+
+		boost::string_ref included_header = code_writer.IncludedHeader();
+		code_writer.CppFile().append("#include \"").append(included_header.data(), included_header.size()).append("\"\n\n");
+
+		SourceEmitter emitter(code_writer, context.scope, first_block);
+		declarations.Emit(emitter);
+
+		code_writer.HeaderFile().append("\n\n#endif // ").append(include_guard).append("\n\n");
+
+		if (code_writer.ForwardDeclarations()) {
+			std::string forward_include_guard = include_guard.substr(0, include_guard.size() - 1) + "FWD_H"; // NAME_H -> NAME_FWD_H
+			WriteForwardDeclarations(declarations, forward_include_guard, code_writer.ForwardHeaderFile());
+		}
+	}
+
+	bool GenerateFileCode(const boost::filesystem::path & filename, GenerationCache::Entry * cache_entry) {
+		GenerationContext context;
+
+		return GenerateFileCode(filename, context, cache_entry);
+	}
+
+	bool GenerateFileCode(const boost::filesystem::path & filename, GenerationContext & context, GenerationCache::Entry * cache_entry) {
+		return GenerateFileCode(filename, boost::filesystem::path(), context, cache_entry);
+	}
+
+	bool GenerateFileCode(const boost::filesystem::path & filename, const boost::filesystem::path & output_dir, GenerationContext & context, GenerationCache::Entry * cache_entry) {
+		using namespace boost::filesystem;
+
+		Statistics::FileTimer file_timer(filename);
+		Statistics::Add(Statistics::Counter::files_processed);
+
+		try {
+			Parser parser(filename, context.parser);
+
+			if (cache_entry != nullptr) cache_entry->hash = Hash(parser.Code(), parser.CodeSize());
+
+			const auto & code_blocks = parser.CodeBlocks();
+
+			if (code_blocks.empty()) {
+				Console::WarningStream() << "File " << filename << " does not contain any code to process" << endl;
+				return false;
+			}
+
+			Statistics::Timer generate_timer(Statistics::Phase::generate);
+
+			// All the outputs are generated from the declarations, found in a single pass over the code blocks
+			context.declarations.Build(code_blocks);
+			FindLocalIncludes(context.declarations, context.includes);
+
+			CodeWriter code_writer(filename, output_dir, parser.CodeSize(), context);
+
+			WriteCode(filename, context.declarations, code_writer, context);
+
+			generate_timer.Stop();
+
+			FileSignature header, cpp;
+			code_writer.Save(header, cpp);
+
+			if (cache_entry != nullptr) {
+				cache_entry->header = header;
+				cache_entry->cpp = cpp;
+			}
+
+			return true;
+		} catch (const filesystem_error & exception) {
+			Console::ErrorStream() << "An error ocurred while processing " << filename << ": " << exception.what() << std::endl;
+		} catch (const Parser::Error & error) {
+			Console::ErrorStream() << "Error at " << filename << " (line " << error.Line() << "): " << error.what() << ": " << error.CodeContainingError() << std::endl;
+		}
+
+		Statistics::Add(Statistics::Counter::files_with_errors);
+
+		return false;
+	}
+
+	bool GenerateCodeInMemory(const char * code, size_t size, const boost::filesystem::path & filename, GeneratedCode & output, GenerationContext & context) {
+		output.error = GenerationError();
+
+		output.header.clear();
+		output.cpp.clear();
+		output.forward_header_filename.clear();
+		output.forward_header.clear();
+		output.includes.clear();
+
+		try {
+			Parser parser(code, size, context.parser);
+
+			const auto & code_blocks = parser.CodeBlocks();
+
+			if (code_blocks.empty()) {
+				output.error.type = GenerationError::Type::no_code;
+				output.error.message = "The code does not contain anything to process";
+				return false;
+			}
+
+			context.declarations.Build(code_blocks);
+			FindLocalIncludes(context.declarations, output.includes);
+
+			CodeWriter code_writer(filename, boost::filesystem::path(), size, context);
+			WriteCode(filename, context.declarations, code_writer, context);
+
+			output.header_filename = context.header_filename;
+			output.cpp_filename = context.cpp_filename;
+			output.header = code_writer.HeaderFile();
+			output.cpp = code_writer.CppFile();
+
+			if (context.forward_declarations) {
+				output.forward_header_filename = context.forward_header_filename;
+				output.forward_header = context.forward_header_file;
+			}
+		} catch (const Parser::Error & error) {
+			output.error.type = GenerationError::Type::syntax;
+			output.error.message = error.what();
+			output.error.line = error.Line();
+			output.error.code_containing_error = error.CodeContainingError();
+			return false;
+		}
+
+		return true;
+	}
+
+	GeneratedCode GenerateCodeInMemory(const std::string & code, const boost::filesystem::path & filename) {
+		GenerationContext context;
+		GeneratedCode output;
+
+		GenerateCodeInMemory(code.data(), code.size(), filename, output, context);
+
+		return output;
+	}
+
+	bool CheckDirectory(const char * base_dir) {
+		using namespace boost::filesystem;
+
+		try {
+			if (!exists(base_dir) || !is_directory(base_dir)) {
+				Console::ErrorStream() << "Could not access directory: " << base_dir << endl;
+				return false;
+			}
+		} catch (const filesystem_error & exception) {
+			Console::ErrorStream() << "An error ocurred while accessing directory '" << base_dir << "': " << exception.what() << endl;
+			return false;
+		}
+
+		return true;
+	}
+
+	// Finds the includes of a file (and the names of its generated files) without generating its code
+	bool FindFileIncludes(const boost::filesystem::path & filename, GenerationContext & context) {
+		try {
+			Parser parser(filename, context.parser);
+			FindLocalIncludes(parser.CodeBlocks(), context.includes);
+		} catch (const boost::filesystem::filesystem_error &) {
+			return false;
+		} catch (const Parser::Error &) {
+			return false;
+		}
+
+		ReplaceExtension(context.cpp_filename, filename, ".cpp");
+		ReplaceExtension(context.header_filename, filename, ".h");
+
+		return true;
+	}
+
+	// The cache does not record the forward declarations headers, which may not have been generated by previous runs
+	bool ForwardHeaderExists(const boost::filesystem::path & filename) {
+		std::string header_filename, forward_header_filename;
+
+		ReplaceExtension(header_filename, filename, ".h");
+		ForwardHeaderFilename(forward_header_filename, header_filename);
+
+		boost::system::error_code error;
+		return boost::filesystem::is_regular_file(forward_header_filename, error);
+	}
+
+	// Estimate of the memory needed to process a file (see MemoryBudget): parsing it and the generated code (about twice its size)
+	size_t MemoryNeeded(uintmax_t file_size) {
+		size_t size = static_cast<size_t>(file_size);
+
+		return Parser::MemoryNeeded(size) + 2 * size;
+	}
+
+	// Releases the storage that a context keeps between files
+	void ReleaseStorage(GenerationContext & context) {
+		bool forward_declarations = context.forward_declarations;
+		OutputWriter * output_writer = context.output_writer;
+
+		context = GenerationContext();
+		context.forward_declarations = forward_declarations;
+		context.output_writer = output_writer;
+	}
+
+	// When dependencies is not null, it receives the dependencies of each file (in the same order of files_to_process)
+	void ProcessFiles(const vector<boost::filesystem::path> & files_to_process, const GenerationOptions & options, GenerationCache * cache, vector<FileDependencies> * dependencies = nullptr) {
+		using namespace boost::filesystem;
+
+		struct FileToProcess {
+			const path * filename;
+			size_t index;
+			uintmax_t size;
+			bool size_available;
+		};
+
+		vector<FileToProcess> files;
+		files.reserve(files_to_process.size());
+
+		for (const path & f : files_to_process) {
+			boost::system::error_code error;
+			auto size = file_size(f, error);
+
+			files.push_back(FileToProcess { &f, files.size(), (error) ? 0 : size, !error });
+		}
+
+		// Larger files are scheduled first, so that they do not end up delaying the whole process
+		stable_sort(files.begin(), files.end(), [] (const FileToProcess & a, const FileToProcess & b) {
+			return a.size > b.size;
+		});
+
+		WorkStealingPool<FileToProcess> pool(options.number_threads);
+
+		// Each worker reuses the storage of its context for all the files it processes
+		vector<GenerationContext> contexts(pool.NumberWorkers());
+		for (auto & context : contexts) context.forward_declarations = options.forward_declarations;
+
+		if (dependencies != nullptr) dependencies->assign(files.size(), FileDependencies());
+
+		// Memory reserved by each worker, which also covers the storage kept by its context between files.
+		// Workers only keep (at most) their share of the budget reserved once they finish processing a file.
+		unique_ptr<MemoryBudget> budget;
+		if (options.max_memory > 0) budget.reset(new MemoryBudget(options.max_memory));
+
+		vector<size_t> reserved(pool.NumberWorkers(), 0);
+		size_t share = options.max_memory / pool.NumberWorkers();
+
+		// The generated files are written asynchronously, while the workers go on generating the code of the next files
+		OutputWriter output_writer(OutputWriter::DEFAULT_NUMBER_THREADS, OutputWriter::DEFAULT_MAX_PENDING_BYTES, budget.get());
+		for (auto & context : contexts) context.output_writer = &output_writer;
+
+		auto ReserveMemory = [&budget, &reserved, &contexts] (size_t worker, uintmax_t size) {
+			size_t needed = MemoryNeeded(size);
+			if (budget == nullptr || needed <= reserved[worker]) return;
+
+			if (!budget->TryReserve(needed - reserved[worker])) {
+				// Backs off, after giving back the storage of its context (otherwise workers could end up waiting for each other)
+				ReleaseStorage(contexts[worker]);
+				budget->Release(reserved[worker]);
+
+				Statistics::Add(Statistics::Counter::memory_waits);
+				budget->Reserve(needed);
+			}
+
+			reserved[worker] = needed;
+		};
+
+		auto ReleaseMemory = [&budget, &reserved, &contexts, share] (size_t worker) {
+			if (budget == nullptr || reserved[worker] <= share) return;
+
+			ReleaseStorage(contexts[worker]);
+			budget->Release(reserved[worker]);
+			reserved[worker] = 0;
+		};
+
+		pool.Run(files, [cache, dependencies, &options, &contexts, &ReserveMemory, &ReleaseMemory] (const FileToProcess & f, size_t worker) {
+			GenerationContext & context = contexts[worker];
+
+			auto RecordDependencies = [&] {
+				(*dependencies)[f.index] = FileDependencies(*f.filename, context.header_filename, context.cpp_filename, context.includes);
+			};
+
+			if (cache != nullptr && f.size_available && cache->IsUpToDate(*f.filename, f.size) && (!options.forward_declarations || ForwardHeaderExists(*f.filename))) {
+				Console::OutputStream() << *f.filename << " (" << f.size << " bytes): up to date" << endl;
+				Statistics::Add(Statistics::Counter::files_up_to_date);
+
+				if (dependencies != nullptr) {
+					ReserveMemory(worker, f.size);
+					if (FindFileIncludes(*f.filename, context)) RecordDependencies();
+					ReleaseMemory(worker);
+				}
+
+				return;
+			}
+
+			ReserveMemory(worker, f.size);
+
+			if (f.size_available) {
+				Console::OutputStream() << *f.filename << " (" << f.size << " bytes)" << endl;
+			} else {
+				Console::OutputStream() << *f.filename << endl;
+			}
+
+			bool generated;
+
+			if (cache == nullptr) {
+				generated = GenerateFileCode(*f.filename, context);
+			} else {
+				GenerationCache::Entry entry;
+
+				boost::system::error_code error;
+				entry.size = f.size;
+				entry.last_write_time = last_write_time(*f.filename, error);
+
+				generated = GenerateFileCode(*f.filename, context, &entry);
+
+				if (generated && f.size_available && !error) {
+					cache->Update(*f.filename, entry);
+				} else {
+					cache->Remove(*f.filename);
+				}
+			}
+
+			if (generated && dependencies != nullptr) RecordDependencies();
+
+			ReleaseMemory(worker);
+		});
+
+		// Files whose outputs could not be written are neither up to date nor have known dependencies
+		vector<const path *> failed_files;
+
+		for (const auto & failure : output_writer.Finish()) {
+			Console::ErrorStream() << "An error ocurred while processing " << *failure.source << ": " << failure.message << endl;
+			failed_files.push_back(failure.source);
+		}
+
+		sort(failed_files.begin(), failed_files.end());
+		failed_files.erase(unique(failed_files.begin(), failed_files.end()), failed_files.end());
+
+		for (const path * f : failed_files) {
+			Statistics::Add(Statistics::Counter::files_with_errors);
+
+			if (cache != nullptr) cache->Remove(*f);
+			if (dependencies != nullptr) (*dependencies)[f - files_to_process.data()] = FileDependencies();
+		}
+	}
+
+	// Writes a dependencies file (depfile or dependency graph), unless it is already up to date
+	bool SaveDependencies(const std::string & filename, const std::string & contents) {
+		try {
+			WriteFileIfChanged(filename, contents);
+		} catch (const boost::filesystem::filesystem_error & exception) {
+			Console::ErrorStream() << "Could not write the dependencies to '" << filename << "': " << exception.what() << endl;
+			return false;
+		}
+
+		return true;
+	}
+
+	void SaveDependencyGraph(const std::string & filename, vector<FileDependencies> & dependencies) {
+		// Files that could not be processed have no dependencies
+		dependencies.erase(remove_if(dependencies.begin(), dependencies.end(), [] (const FileDependencies & d) { return d.source.empty(); }), dependencies.end());
+
+		ostringstream graph;
+		WriteDependencyGraph(graph, dependencies);
+
+		SaveDependencies(filename, graph.str());
+	}
+
+	void SaveCache(GenerationCache * cache) {
+		if (cache == nullptr) return;
+
+		try {
+			cache->Save();
+		} catch (const boost::filesystem::filesystem_error & exception) {
+			Console::WarningStream() << "Could not save the cache: " << exception.what() << endl;
+		}
+	}
+
+	int GenerateCode(const char * base_dir, const GenerationOptions & options) {
+		constexpr int OK_RESULT = 0;
+		constexpr int ERROR_RESULT = 1;
+
+		if (!CheckDirectory(base_dir)) return ERROR_RESULT;
+
+		Console::OutputStream() << "Processing directory: " << base_dir << endl;
+
+		Statistics::Timer discovery_timer(Statistics::Phase::discovery);
+		vector<boost::filesystem::path> files_to_process = GetFilesToProcess(base_dir, options.number_threads, options.exclude);
+		discovery_timer.Stop();
+
+		auto number_files_to_process = files_to_process.size();
+
+		vector<FileDependencies> dependencies;
+		vector<FileDependencies> * wanted_dependencies = (options.dependency_graph.empty()) ? nullptr : &dependencies;
+
+		if (files_to_process.size() == 0) {
+			Console::WarningStream() << "No extend C++ files (.cppx) found in '" << base_dir << "' or in its subdirectories" << endl;
+		} else {
+			Console::OutputStream() << "Found " << number_files_to_process << " files to process:" << endl;
+
+			unique_ptr<GenerationCache> cache;
+			if (options.use_cache) cache.reset(new GenerationCache(base_dir));
+
+			ProcessFiles(files_to_process, options, cache.get(), wanted_dependencies);
+			SaveCache(cache.get());
+		}
+
+		if (wanted_dependencies != nullptr) SaveDependencyGraph(options.dependency_graph, dependencies);
+		if (options.unity_files_per_unit > 0) WriteUnityBuild(base_dir, files_to_process, options.unity_files_per_unit);
+
+		return OK_RESULT;
+	}
+
+	int GenerateSingleFileCode(const char * filename, const char * output_dir, const char * depfile, bool forward_declarations) {
+		using namespace boost::filesystem;
+
+		constexpr int OK_RESULT = 0;
+		constexpr int ERROR_RESULT = 1;
+
+		path output_path((output_dir != nullptr) ? output_dir : "");
+
+		try {
+			if (!is_regular_file(filename)) {
+				Console::ErrorStream() << "Could not access file: " << filename << endl;
+				return ERROR_RESULT;
+			}
+
+			if (!output_path.empty()) create_directories(output_path);
+		} catch (const filesystem_error & exception) {
+			Console::ErrorStream() << "An error ocurred while accessing '" << filename << "': " << exception.what() << endl;
+			return ERROR_RESULT;
+		}
+
+		GenerationContext context;
+		context.forward_declarations = forward_declarations;
+
+		if (!GenerateFileCode(filename, output_path, context)) return ERROR_RESULT;
+
+		if (depfile != nullptr && *depfile) {
+			ostringstream contents;
+			WriteDepfile(contents, FileDependencies(filename, context.header_filename, context.cpp_filename, context.includes));
+
+			if (!SaveDependencies(depfile, contents.str())) return ERROR_RESULT;
+		}
+
+		return OK_RESULT;
+	}
+
+	int WatchCode(const char * base_dir, const GenerationOptions & options) {
+		using namespace boost::filesystem;
+
+		constexpr int ERROR_RESULT = 1;
+
+		// Changes are gathered until no more arrive during this period, so that 
+		// saving several files at once (or a file in several steps) triggers a single pass.
+		constexpr int QUIET_PERIOD_MILLISECONDS = 50;
+
+		if (!CheckDirectory(base_dir)) return ERROR_RESULT;
+
+		unique_ptr<FileWatcher> watcher;
+
+		try {
+			watcher.reset(new FileWatcher(base_dir));
+		} catch (const filesystem_error & exception) {
+			Console::ErrorStream() << exception.what() << endl;
+			return ERROR_RESULT;
+		}
+
+		// The watcher is created first, so that no changes are missed during the initial pass
+		GenerateCode(base_dir, options);
+
+		unique_ptr<GenerationCache> cache;
+		if (options.use_cache) cache.reset(new GenerationCache(base_dir));
+
+		// Reloaded on each rescan, since .cppxignore may have changed
+		ExclusionList exclusions(base_dir, options.exclude);
+
+		Console::OutputStream() << "Watching directory: " << base_dir << " (press Ctrl+C to stop)" << endl;
+
+		for (;;) {
+			vector<FileWatcher::Change> changes;
+
+			watcher->WaitForChanges(changes, -1);
+			while (watcher->WaitForChanges(changes, QUIET_PERIOD_MILLISECONDS));
+
+			vector<path> files_to_process;
+			bool rescan = false;
+
+			for (const auto & change : changes) {
+				if (change.type == FileWatcher::Change::Type::rescan) {
+					rescan = true;
+				} else if (change.type == FileWatcher::Change::Type::removed) {
+					if (cache) cache->Remove(change.filename);
+				} else if (find(files_to_process.begin(), files_to_process.end(), change.filename) == files_to_process.end()) {
+					files_to_process.push_back(change.filename);
+				}
+			}
+
+			if (rescan) {
+				// Events were lost. The cache (when used) avoids regenerating the files that did not change.
+				exclusions = ExclusionList(base_dir, options.exclude);
+				files_to_process = FindFiles(base_dir, ".cppx", exclusions, options.number_threads);
+			}
+
+			// Files modified and removed within the same batch no longer need to be processed
+			files_to_process.erase(remove_if(files_to_process.begin(), files_to_process.end(), [&] (const path & f) {
+				boost::system::error_code error;
+				return !is_regular_file(f, error) || exclusions.ExcludesFile(base_dir, f);
+			}), files_to_process.end());
+
+			if (!files_to_process.empty()) {
+				Console::OutputStream() << "Changes detected in " << files_to_process.size() << " files:" << endl;
+				ProcessFiles(files_to_process, options, cache.get());
+			}
+
+			SaveCache(cache.get());
+
+			// Files may have been added or removed, which changes the groups of the unity build
+			if (options.unity_files_per_unit > 0) {
+				WriteUnityBuild(base_dir, FindFiles(base_dir, ".cppx", exclusions, options.number_threads), options.unity_files_per_unit);
+			}
+		}
+	}
+}
@@ -0,0 +1,182 @@
+/*
+	Noel Lopes is a Professor at the Polytechnic of Guarda, Portugal
+	and a Researcher at the CISUC - University of Coimbra, Portugal
+	Copyright (C) 2017 Noel de Jesus Mendonça Lopes
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+#ifndef CPPX_CODE_GENERATOR_H
+#define CPPX_CODE_GENERATOR_H
+
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "declarations.h"
+#include "generation_cache.h"
+#include "output_writer.h"
+#include "parser.h"
+
+namespace cppx {
+
+	/// Options for processing the extended C++ files of a directory (see GenerateCode and WatchCode).
+	struct GenerationOptions {
+		size_t number_threads; // number of threads used to find and to process the files
+		bool use_cache; // whether to skip the files that did not change since the last run (see GenerationCache)
+		std::vector<std::string> exclude; // glob patterns of the files and directories to exclude, besides those in .cppxignore (see ExclusionList)
+		std::string dependency_graph; // if not empty, file where GenerateCode writes the dependency graph (JSON) of the .cppx files (see WriteDependencyGraph)
+		size_t unity_files_per_unit; // if greater than 0, unity build files including (on average) this number of generated .cpp files are also written (see WriteUnityBuild)
+		bool forward_declarations; // whether a header with the forward declarations (<name>_fwd.h) is also generated for each file
+		size_t max_memory; // if greater than 0, memory budget (in bytes) for the input, code blocks and pending output of all the threads (see MemoryBudget)
+
+		GenerationOptions() : number_threads(1), use_cache(true), unity_files_per_unit(0), forward_declarations(false), max_memory(0) {}
+	};
+
+	/// Returns the extended C++ files to process.
+	/// \param base_dir Base directory where to look for the .cppx files. 
+	///        Its subdirectories will also be scanned for .cppx files.
+	/// \param number_threads Number of threads used to scan the directories.
+	/// \param exclude Glob patterns of the files and directories to exclude, besides 
+	///        the version control directories and the patterns in .cppxignore (see ExclusionList).
+	/// \return A vector (sorted) containing the .cppx files to process
+	std::vector<boost::filesystem::path> GetFilesToProcess(const char * base_dir, size_t number_threads = 1, const std::vector<std::string> & exclude = std::vector<std::string>());
+
+	/// Storage reused by GenerateFileCode across several files (e.g. all the files processed by a thread).
+	/// Its buffers keep their capacity between files, so that (once they are large enough) generating 
+	/// the code of a file requires (almost) no memory allocations. A context can only be used by a single thread at a time.
+	struct GenerationContext {
+		Parser::Context parser;
+		Declarations declarations;
+
+		std::string header_filename;
+		std::string cpp_filename;
+
+		std::string header_file;
+		std::string cpp_file;
+		std::string buffer;
+		std::string scope;
+
+		std::vector<std::string> includes; // local includes of the last file processed (see FindLocalIncludes)
+
+		bool forward_declarations; // whether a header with the forward declarations (<name>_fwd.h) is also generated
+		std::string forward_header_filename;
+		std::string forward_header_file;
+
+		OutputWriter * output_writer; // if not null, the generated files are written asynchronously by it (see OutputWriter)
+
+		GenerationContext() : forward_declarations(false), output_writer(nullptr) {}
+	};
+
+	/// Generates C++ code (.h and .cpp files) from a specific extended C++ file (.cppx)
+	/// \param filename filename (.cppx) to process
+	/// \param cache_entry if not null, it will be filled with the hash of the file and the signatures of the generated files
+	/// \return true if the .h and .cpp files were generated. false otherwise.
+	/// \sa GenerateCode
+	bool GenerateFileCode(const boost::filesystem::path & filename, GenerationCache::Entry * cache_entry = nullptr);
+
+	/// Generates C++ code (.h and .cpp files) from a specific extended C++ file (.cppx), reusing the storage of a context
+	/// \param filename filename (.cppx) to process
+	/// \param context context that provides the storage used while generating the code
+	/// \param cache_entry if not null, it will be filled with the hash of the file and the signatures of the generated files
+	/// \return true if the .h and .cpp files were generated. false otherwise.
+	bool GenerateFileCode(const boost::filesystem::path & filename, GenerationContext & context, GenerationCache::Entry * cache_entry = nullptr);
+
+	/// Generates C++ code (.h and .cpp files) from a specific extended C++ file (.cppx) in a given directory
+	/// (e.g. in the build tree), reusing the storage of a context. The source file includes the header by its name.
+	/// \param filename filename (.cppx) to process
+	/// \param output_dir directory of the generated files (which must exist). If empty, the files are generated next to \a filename
+	/// \param context context that provides the storage used while generating the code
+	/// \param cache_entry if not null, it will be filled with the hash of the file and the signatures of the generated files
+	/// \return true if the .h and .cpp files were generated. false otherwise.
+	bool GenerateFileCode(const boost::filesystem::path & filename, const boost::filesystem::path & output_dir, GenerationContext & context, GenerationCache::Entry * cache_entry = nullptr);
+
+	/// Error found while generating code in memory (see GenerateCodeInMemory).
+	struct GenerationError {
+		enum class Type {
+			none,
+			no_code, // the code does not contain anything to process
+			syntax // the code is not valid (see Parser::Error)
+		};
+
+		Type type;
+		std::string message;
+		size_t line; // line where a syntax error was found
+		std::string code_containing_error; // code where a syntax error was found
+
+		GenerationError() : type(Type::none), line(0) {}
+	};
+
+	/// C++ code generated in memory from extended C++ code (see GenerateCodeInMemory).
+	struct GeneratedCode {
+		std::string header_filename;
+		std::string cpp_filename;
+
+		std::string header;
+		std::string cpp;
+
+		std::string forward_header_filename; // only when the context generates forward declarations headers
+		std::string forward_header;
+
+		std::vector<std::string> includes; // local includes (see FindLocalIncludes)
+
+		GenerationError error;
+	};
+
+	/// Generates C++ code (.h and .cpp) from extended C++ code held in memory, without reading or writing 
+	/// any files and without any console output, so that the generator can be embedded (e.g. in editors 
+	/// and build servers). Several threads can generate code concurrently, provided that each one uses its own context.
+	/// \param code extended C++ code (it does not need to be null-terminated)
+	/// \param size size of the code
+	/// \param filename name of the .cppx file (which does not need to exist), used to name the generated files and to create the include guard
+	/// \param output receives the generated code or the error found (its strings keep their capacity between calls)
+	/// \param context context that provides the storage used while generating the code
+	/// \return true if the code was generated. false otherwise (see GeneratedCode::error).
+	bool GenerateCodeInMemory(const char * code, size_t size, const boost::filesystem::path & filename, GeneratedCode & output, GenerationContext & context);
+
+	/// Generates C++ code (.h and .cpp) from extended C++ code held in memory (see the overload above).
+	/// \param code extended C++ code
+	/// \param filename name of the .cppx file (which does not need to exist), used to name the generated files and to create the include guard
+	/// \return the generated code or the error found (see GeneratedCode::error).
+	GeneratedCode GenerateCodeInMemory(const std::string & code, const boost::filesystem::path & filename);
+
+	/// Generates C++ code (.h and .cpp files) from all extended C++ files (.cppx) contained within the 
+	/// \a base_dir directory and its subdirectories
+	/// \param base_dir base directory for processing the .cppx files
+	/// \param options options (number of threads, cache, files to exclude, ...)
+	/// \return 0 if successfull. An error code otherwise.
+	/// \sa GenerateFileCode
+	int GenerateCode(const char * base_dir, const GenerationOptions & options);
+
+	/// Generates C++ code (.h and .cpp files) from a single extended C++ file (.cppx), so that build systems 
+	/// can generate each file separately (and in parallel), only when it changes (see cmake/cppx.cmake).
+	/// \param filename filename (.cppx) to process
+	/// \param output_dir directory of the generated files, which is created if needed. If null or empty, the files are generated next to \a filename
+	/// \param depfile if not null (nor empty), file where a Makefile style depfile is written (see WriteDepfile)
+	/// \param forward_declarations whether a header with the forward declarations (<name>_fwd.h) is also generated
+	/// \return 0 if the .h and .cpp files were generated (or were already up to date). An error code otherwise.
+	/// \sa GenerateFileCode
+	int GenerateSingleFileCode(const char * filename, const char * output_dir = nullptr, const char * depfile = nullptr, bool forward_declarations = false);
+
+	/// Generates C++ code from all extended C++ files (.cppx) contained within the \a base_dir directory 
+	/// and its subdirectories (see GenerateCode) and then keeps watching the directory, regenerating 
+	/// only the .cppx files that are created or modified. This function only returns on error.
+	/// \param base_dir base directory for processing the .cppx files
+	/// \param options options (number of threads, cache, files to exclude, ...)
+	/// \return An error code.
+	/// \sa FileWatcher
+	int WatchCode(const char * base_dir, const GenerationOptions & options);
+}
+
+#endif // CPPX_CODE_GENERATOR_H
@@ -16,36 +16,215 @@
 	limitations under the License.
 */
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
 #include "console.h"
 #include "rang.hpp"
 
 namespace cppx {
+	struct Console::ThreadBuffer {
+		struct Entry {
+			uint64_t first_message;
+			uint64_t last_message; // consecutive messages written by the same thread to the same stream share an entry
+			Stream stream;
+			std::string text;
+		};
+
+		std::mutex mutex;
+		std::vector<Entry> entries;
+	};
+
+	struct Console::BufferedOutput {
+		std::mutex mutex;
+		std::vector<std::shared_ptr<ThreadBuffer>> buffers; // a buffer is only referenced here once its thread finishes
+
+		std::atomic<uint64_t> next_message;
+
+		std::chrono::steady_clock::duration flush_interval;
+		std::atomic<std::chrono::steady_clock::rep> next_flush;
+
+		BufferedOutput() : next_message(0), next_flush(0) {}
+	};
+
+	namespace {
+		// Colors are only used when the output is a terminal (checked only once)
+		bool UseColors(std::ostream & os) {
+			static const bool colors_in_output = rang::rang_implementation::supportsColor() && rang::rang_implementation::isTerminal(std::cout.rdbuf());
+			static const bool colors_in_errors = rang::rang_implementation::supportsColor() && rang::rang_implementation::isTerminal(std::cerr.rdbuf());
+
+			return (&os == &std::cout) ? colors_in_output : colors_in_errors;
+		}
+	}
+
+	constexpr int Console::DEFAULT_FLUSH_INTERVAL_MILLISECONDS;
+
 	Console::Stream Console::current_stream = Console::Stream::error;
+	std::mutex Console::mutex;
+	Console::Verbosity Console::verbosity = Console::Verbosity::normal;
+	bool Console::buffered = false;
+	thread_local std::shared_ptr<Console::ThreadBuffer> Console::thread_buffer;
 
-	std::ostream & Console::ErrorStream() {
-		if (current_stream != Stream::error) {
-			current_stream = Stream::error;
-			std::cerr << rang::fgB::red;
+	Console::BufferedOutput & Console::Buffers() {
+		static BufferedOutput output;
+
+		return output;
+	}
+
+	void Console::SetVerbosity(Verbosity verbosity) {
+		Console::verbosity = verbosity;
+	}
+
+	void Console::SetBuffered(bool buffered, std::chrono::milliseconds flush_interval) {
+		if (!buffered) Flush();
+
+		BufferedOutput & output = Buffers();
+
+		output.flush_interval = flush_interval;
+		output.next_flush = (std::chrono::steady_clock::now() + flush_interval).time_since_epoch().count();
+
+		Console::buffered = buffered;
+	}
+
+	void Console::Write(Stream stream, const std::string & text) {
+		if (text.empty()) return;
+
+		if (buffered) {
+			Buffer(stream, text);
+		} else {
+			std::lock_guard<std::mutex> lock(mutex);
+
+			Output(stream, text);
+			((stream == Stream::standard || stream == Stream::summary) ? std::cout : std::cerr).flush();
 		}
+	}
+
+	// Must be called with the mutex locked
+	void Console::Output(Stream stream, const std::string & text) {
+		bool standard = (stream == Stream::standard || stream == Stream::summary);
+		std::ostream & os = standard ? std::cout : std::cerr;
+
+		if (standard) stream = Stream::standard;
+
+		if (current_stream != stream) {
+			current_stream = stream;
+
+			if (UseColors(os)) {
+				// The output is known to be a terminal (so rang does not need to check it again)
+				os << rang::control::forceColor;
+
+				switch (stream) {
+					case Stream::error:
+						os << rang::fgB::red;
+						break;
+
+					case Stream::warning:
+						os << rang::fgB::yellow;
+						break;
 
-		return std::cerr;
+					default:
+						os << rang::style::reset;
+						break;
+				}
+			}
+		}
+
+		os << text;
 	}
 
-	std::ostream & Console::WarningStream() {
-		if (current_stream != Stream::warning) {
-			current_stream = Stream::warning;
-			std::cerr << rang::fgB::yellow;
+	void Console::Buffer(Stream stream, const std::string & text) {
+		BufferedOutput & output = Buffers();
+
+		if (thread_buffer == nullptr) {
+			thread_buffer = std::make_shared<ThreadBuffer>();
+
+			std::lock_guard<std::mutex> lock(output.mutex);
+			output.buffers.push_back(thread_buffer);
+		}
+
+		uint64_t message = output.next_message.fetch_add(1);
+
+		{
+			std::lock_guard<std::mutex> lock(thread_buffer->mutex);
+			auto & entries = thread_buffer->entries;
+
+			if (!entries.empty() && entries.back().stream == stream && entries.back().last_message + 1 == message) {
+				entries.back().text += text;
+				entries.back().last_message = message;
+			} else {
+				entries.push_back(ThreadBuffer::Entry { message, message, stream, text });
+			}
 		}
 
-		return std::cerr;
+		auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+		if (now >= output.next_flush.load(std::memory_order_relaxed)) FlushBuffers(false);
 	}
 
-	std::ostream & Console::OutputStream() {
-		if (current_stream != Stream::standard) {
-			current_stream = Stream::standard;
-			std::cout << rang::style::reset;
+	// When wait is false, the buffers are not flushed if another thread is already flushing them
+	void Console::FlushBuffers(bool wait) {
+		std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+
+		if (wait) {
+			lock.lock();
+		} else if (!lock.try_lock()) {
+			return;
+		}
+
+		BufferedOutput & output = Buffers();
+		output.next_flush = (std::chrono::steady_clock::now() + output.flush_interval).time_since_epoch().count();
+
+		std::vector<ThreadBuffer::Entry> entries;
+
+		{
+			std::lock_guard<std::mutex> buffers_lock(output.mutex);
+
+			for (auto b = output.buffers.begin(); b != output.buffers.end();) {
+				bool thread_finished = (b->use_count() == 1);
+
+				{
+					std::lock_guard<std::mutex> buffer_lock((*b)->mutex);
+
+					std::move((*b)->entries.begin(), (*b)->entries.end(), std::back_inserter(entries));
+					(*b)->entries.clear();
+				}
+
+				b = thread_finished ? output.buffers.erase(b) : b + 1;
+			}
 		}
 
-		return std::cout;
+		if (entries.empty()) return;
+
+		// Entries do not overlap (each one only contains consecutive messages)
+		std::sort(entries.begin(), entries.end(), [] (const ThreadBuffer::Entry & a, const ThreadBuffer::Entry & b) {
+			return a.first_message < b.first_message;
+		});
+
+		for (const auto & entry : entries) Output(entry.stream, entry.text);
+
+		std::cout.flush();
+		std::cerr.flush();
+	}
+
+	void Console::Flush() {
+		FlushBuffers(true);
+	}
+
+	Console::Message Console::ErrorStream() {
+		return Message(Stream::error);
+	}
+
+	Console::Message Console::WarningStream() {
+		return Message(Stream::warning);
+	}
+
+	Console::Message Console::OutputStream() {
+		return Message(Stream::standard);
+	}
+
+	Console::Message Console::SummaryStream() {
+		return Message(Stream::summary);
 	}
-}
\ No newline at end of file
+}
@@ -19,40 +19,144 @@
 #ifndef CPPX_CONSOLE_H
 #define CPPX_CONSOLE_H
 
+#include <chrono>
 #include <iostream>
+#include <memory>
+#include <sstream>
+#include <mutex>
 
 namespace cppx {
 
 	/// Console class that provides three output streams 
 	/// ([default] Output, Warning and Error), using appropriate 
-	/// terminal colors for each one.
+	/// terminal colors for each one (only when the output is 
+	/// a terminal).
 	/// Uses the rang c++ library for colors in the terminal 
 	/// (https://github.com/agauniyal/rang)
+	/// The console can be safely used by several threads: each
+	/// statement written to a stream is buffered and output as 
+	/// a whole, without being interleaved with the output of 
+	/// other threads.
 	class Console {
+	public:
+		/// Amount of output (see SetVerbosity).
+		enum class Verbosity {
+			normal,
+			summary, // only errors and the summary of the run (see SummaryStream)
+			quiet    // only errors
+		};
+
+		/// Default interval between the flushes of the buffered output (see SetBuffered).
+		static constexpr int DEFAULT_FLUSH_INTERVAL_MILLISECONDS = 500;
 
 	private:
 
 		enum class Stream {
 			standard,
+			summary,
 			warning,
 			error
 		};
 
+		struct ThreadBuffer; // messages written by a thread, while the output is buffered (see SetBuffered)
+		struct BufferedOutput; // buffers of all the threads
+
 		static Stream current_stream;
+		static std::mutex mutex;
+		static Verbosity verbosity;
+		static bool buffered;
+		static thread_local std::shared_ptr<ThreadBuffer> thread_buffer;
+
+		static BufferedOutput & Buffers();
+
+		static void Write(Stream stream, const std::string & text);
+		static void Output(Stream stream, const std::string & text);
+		static void Buffer(Stream stream, const std::string & text);
+		static void FlushBuffers(bool wait);
+
+		static bool Enabled(Stream stream) {
+			switch (verbosity) {
+				case Verbosity::quiet:
+					return stream == Stream::error;
+
+				case Verbosity::summary:
+					return stream == Stream::error || stream == Stream::summary;
+
+				default:
+					return true;
+			}
+		}
 
 	public:
 
+		/// Message being written to one of the console streams.
+		/// Its contents are output when the message is destroyed
+		/// (at the end of the statement that created it). Messages
+		/// to streams disabled by the verbosity are not even formatted.
+		class Message {
+		private:
+			Stream stream;
+			bool enabled;
+			std::ostringstream text;
+
+		public:
+			explicit Message(Stream stream) : stream(stream), enabled(Enabled(stream)) {}
+
+			Message(Message && other) : stream(other.stream), enabled(other.enabled), text(other.text.str()) {
+				other.text.str(std::string());
+			}
+
+			Message(const Message &) = delete;
+			Message & operator = (const Message &) = delete;
+
+			~Message() {
+				if (enabled) Write(stream, text.str());
+			}
+
+			template <typename T>
+			Message & operator << (const T & value) {
+				if (enabled) text << value;
+				return *this;
+			}
+
+			Message & operator << (std::ostream & (*manipulator)(std::ostream &)) {
+				if (enabled) text << manipulator;
+				return *this;
+			}
+		};
+
+		/// Sets the amount of output. Should be called before any other thread uses the console.
+		/// \param verbosity Verbosity (by default Verbosity::normal).
+		static void SetVerbosity(Verbosity verbosity);
+
+		/// Enables (or disables) the buffered output. Each thread keeps the messages it writes in a 
+		/// buffer of its own, so that writing a message does not flush the streams (nor contends with 
+		/// other threads). The buffers are output, with the messages in the order they were written, 
+		/// by Flush, which is also called (at the given interval) while messages are being written. 
+		/// Should be called before any other thread uses the console. Disabling it flushes the buffers.
+		/// \param buffered Whether the output is buffered (by default it is not).
+		/// \param flush_interval Interval between flushes.
+		static void SetBuffered(bool buffered, std::chrono::milliseconds flush_interval = std::chrono::milliseconds(DEFAULT_FLUSH_INTERVAL_MILLISECONDS));
+
+		/// Outputs the messages kept in the buffers of all the threads (see SetBuffered).
+		static void Flush();
+
 		/// Returns an error stream (std::cerr) that will use write red text on the terminal.
 		/// \return Error stream.
-		static std::ostream & ErrorStream();
+		static Message ErrorStream();
 
 		/// Returns an error stream (std::cerr) that will use write yellow text on the terminal.
 		/// \return Warning stream.
-		static std::ostream & WarningStream();
+		static Message WarningStream();
 
 		/// Returns the default output stream (std::cout).
 		/// \return Default output stream.
-		static std::ostream & OutputStream();
+		static Message OutputStream();
+
+		/// Returns the output stream (std::cout) for the summary of a run, which 
+		/// is also output when the verbosity is Verbosity::summary.
+		/// \return Summary stream.
+		static Message SummaryStream();
 	};
 }
 
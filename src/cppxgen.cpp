@@ -19,427 +19,291 @@
 /// \file cppxgen.cpp
 /// cppxgen tool: converts extended C++ files (.cppx) to standard C++ files (.h and .cpp)
 
-#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
 #include <fstream>
 #include <sstream>
-#include <vector>
-#include <boost/filesystem.hpp>
+#include <string>
+#include <thread>
 
+#ifdef __GLIBC__
+	#include <malloc.h>
+#endif
+
+#include "code_generator.h"
 #include "console.h"
 #include "parser.h"
+#include "source_file.h"
+#include "statistics.h"
 
 using namespace cppx;
 using namespace std;
 
-/// Returns the extended C++ files to process.
-/// \param base_dir Base directory where to look for the .cppx files. 
-///        Its subdirectories will also be scanned for .cppx files.
-/// \param files_to_process Vector that will be appended with the files 
-///        to process contained in the \a base_dir directory and its 
-///        subdirectories.
-/// \return A vector containing the .cppx files to process
-vector<boost::filesystem::path> GetFilesToProcess(const char * base_dir) {
-	using namespace boost::filesystem;
-
-	vector<path> files_to_process;
-
-	try {
-		for (const auto & entry : recursive_directory_iterator(base_dir)) {
-			auto path = entry.path();
-			if (path.extension() == ".cppx" && is_regular_file(path)) {
-				files_to_process.push_back(path);
-			}
-		}
-	} catch (const filesystem_error & exception) {
-		Console::ErrorStream() << "An error ocurred while obtaining the files to process: " << exception.what() << endl;
-	}
+/// Parses a memory size, in bytes, optionally followed by a K, M or G suffix (e.g. 512M).
+/// \return true if the size is valid, false otherwise.
+bool ParseMemorySize(const string & value, size_t & bytes) {
+	char * end;
+	bytes = strtoul(value.c_str(), &end, 10);
 
-	return files_to_process;
-}
+	if (value.empty() || end == value.c_str()) return false;
 
-std::string CodeGuardNamespaces(const std::vector<Parser::CodeBlock> & code_blocks) {
-	std::string result;
+	size_t unit = 1;
 
-	auto block = code_blocks.cbegin();
+	switch (*end) {
+		case 'k':
+		case 'K':
+			unit = 1024;
+			break;
 
-	auto ProcessNamespace = [&] {
-		std::string namespace_identifer;
+		case 'm':
+		case 'M':
+			unit = 1024 * 1024;
+			break;
 
-		while (++block != code_blocks.cend()) {
-			switch (block->type) {
-				case Parser::CodeBlock::Type::begin_group:
-					result += namespace_identifer;
-					return;
+		case 'g':
+		case 'G':
+			unit = 1024 * 1024 * 1024;
+			break;
+	}
 
-				case Parser::CodeBlock::Type::statement_terminator:
-					return;
+	if (unit > 1) ++end;
+	if (*end == 'b' || *end == 'B') ++end;
 
-				case Parser::CodeBlock::Type::identifier:
-					namespace_identifer += block->ToString() + "_";
-					break;
+	bytes *= unit;
 
-				default:
-					break;
-			}
-		}
-	};
-
-	for (; block != code_blocks.cend(); ++block) {
-		switch (block->type) {
-			case Parser::CodeBlock::Type::namespace_keyword:
-				ProcessNamespace();
-				break;
-
-			case Parser::CodeBlock::Type::enumeration:
-			case Parser::CodeBlock::Type::class_keyword:
-			case Parser::CodeBlock::Type::struct_keyword:
-				while (++block != code_blocks.cend()) {
-					if (block->type == Parser::CodeBlock::Type::begin_group) {
-						return result;
-					} else if (block->type == Parser::CodeBlock::Type::statement_terminator) {
-						break;
-					}
-				}
-				break;
-
-			default:
-				break;
-		}
-	}
-
-	return result;
+	return *end == 0;
 }
 
-std::string CodeGuardIdentifier(const boost::filesystem::path & path, const std::vector<Parser::CodeBlock> & code_blocks) {
-	std::string result = CodeGuardNamespaces(code_blocks);
+/// Returns a memory size in a human readable form (e.g. 512 MB).
+string MemorySize(size_t bytes) {
+	constexpr size_t KILOBYTE = 1024;
+	constexpr size_t MEGABYTE = 1024 * KILOBYTE;
 
-	result += path.stem().string() + "_H";
+	ostringstream size;
 
-	for (auto & c : result) c = toupper(c);
+	if (bytes < MEGABYTE) {
+		size << (bytes + KILOBYTE / 2) / KILOBYTE << " KB";
+	} else {
+		size << (bytes + MEGABYTE / 2) / MEGABYTE << " MB";
+	}
 
-	return result;
+	return size.str();
 }
 
-class CodeWriter {
-private:
-	std::ofstream cpp_file;
-	std::ofstream header_file;
-
-	std::string buffer;
+void PrintBanner() {
+	Console::OutputStream() << CPPX_VERSION_STRING << endl;
+	Console::OutputStream() << "Converts extended C++ files (.cppx) to standard C++ files (.h and .cpp)" << endl;
+	Console::OutputStream() << "Usage: cppxgen [options] [base directory (default current) | file.cppx]" << endl;
+	Console::OutputStream() << endl;
+}
 
-public:
-	CodeWriter(const std::string & cpp_filename, const std::string & header_filename) :
-		cpp_file(cpp_filename, std::ofstream::binary),
-		header_file(header_filename, std::ofstream::binary) {
-	}
+void PrintOptions() {
+	Console::OutputStream() << "Options:" << endl;
+	Console::OutputStream() << "  -j <threads>              number of threads (default: number of hardware threads)" << endl;
+	Console::OutputStream() << "  -o <directory>            output directory of the generated files (only when processing a single .cppx file)" << endl;
+	Console::OutputStream() << "  --depfile=<file>          write a depfile (Makefile style) with the local includes (only when processing a single .cppx file)" << endl;
+	Console::OutputStream() << "  --deps-json=<file>        write the dependency graph (JSON) of the .cppx files, including their local includes" << endl;
+	Console::OutputStream() << "  --unity=<N>               also write unity build files, each including about N generated .cpp files" << endl;
+	Console::OutputStream() << "  --fwd                     also write a header with the forward declarations (<name>_fwd.h) of each file" << endl;
+	Console::OutputStream() << "  --no-cache                process all the files, ignoring the cache (.cppxcache)" << endl;
+	Console::OutputStream() << "  --exclude=<glob>          exclude the files and directories matching the pattern (see also .cppxignore)" << endl;
+	Console::OutputStream() << "  --max-memory=<size>       memory budget (e.g. 512M) for the input, code blocks and pending output of all the threads" << endl;
+	Console::OutputStream() << "  --mmap-threshold=<bytes>  memory map the files with at least this size (default " << SourceFile::DEFAULT_MEMORY_MAP_THRESHOLD << ")" << endl;
+	Console::OutputStream() << "  -q                        quiet: only output errors" << endl;
+	Console::OutputStream() << "  --summary                 only output errors and a single line with the totals" << endl;
+	Console::OutputStream() << "  --watch                   keep watching the directory, regenerating the files that change" << endl;
+	Console::OutputStream() << "  --stats[=N]               output statistics, including the N slowest files (default 10)" << endl;
+	Console::OutputStream() << "  --stats-json=<file>       write the statistics (JSON) to a file" << endl;
+	Console::OutputStream() << "  --help                    show this information" << endl;
+}
 
-	CodeWriter(const CodeWriter &) = delete;
-	CodeWriter & operator = (const CodeWriter &) = delete;
+/// Main entry point for cppxgen tool
+/// Converts extended C++ files (.cppx) to standard C++ files (.h and .cpp).
+/// When a single .cppx file is given, only that file is processed (see GenerateSingleFileCode).
+/// Usage: cppxgen [options] [base directory (default current) | file.cppx]
+int main(int argc, char * argv[]) {
+	constexpr size_t DEFAULT_NUMBER_SLOWEST_FILES = 10;
+
+	const char * base_dir = "./";
+	const char * output_dir = nullptr;
+	const char * depfile = nullptr;
+	GenerationOptions options;
+	options.number_threads = max(thread::hardware_concurrency(), 1u);
+	bool watch = false;
+	Console::Verbosity verbosity = Console::Verbosity::normal;
+	bool print_statistics = false;
+	size_t number_slowest_files = DEFAULT_NUMBER_SLOWEST_FILES;
+	string statistics_json_filename;
+
+	for (int a = 1; a < argc; ++a) {
+		string argument = argv[a];
+
+		if (argument.compare(0, 2, "-j") == 0) {
+			string value = (argument.size() > 2) ? argument.substr(2) : ((a + 1 < argc) ? argv[++a] : "");
+
+			char * end;
+			options.number_threads = strtoul(value.c_str(), &end, 10);
+
+			if (value.empty() || *end || options.number_threads == 0) {
+				Console::ErrorStream() << "Invalid number of threads: '" << value << "'" << endl;
+				return 1;
+			}
+		} else if (argument.compare(0, 2, "-o") == 0) {
+			output_dir = (argument.size() > 2) ? argv[a] + 2 : ((a + 1 < argc) ? argv[++a] : "");
 
-	~CodeWriter() {
-		WriteBufferToHeader();
-	}
+			if (!*output_dir) {
+				Console::ErrorStream() << "Missing output directory" << endl;
+				return 1;
+			}
+		} else if (argument.compare(0, 10, "--depfile=") == 0 && argument.size() > 10) {
+			depfile = argv[a] + 10;
+		} else if (argument.compare(0, 12, "--deps-json=") == 0 && argument.size() > 12) {
+			options.dependency_graph = argument.substr(12);
+		} else if (argument.compare(0, 8, "--unity=") == 0) {
+			string value = argument.substr(8);
+
+			char * end;
+			options.unity_files_per_unit = strtoul(value.c_str(), &end, 10);
+
+			if (value.empty() || *end || options.unity_files_per_unit == 0) {
+				Console::ErrorStream() << "Invalid number of files per unity build file: '" << value << "'" << endl;
+				return 1;
+			}
+		} else if (argument == "--fwd") {
+			options.forward_declarations = true;
+		} else if (argument == "--no-cache") {
+			options.use_cache = false;
+		} else if (argument.compare(0, 10, "--exclude=") == 0 && argument.size() > 10) {
+			options.exclude.push_back(argument.substr(10));
+		} else if (argument.compare(0, 17, "--mmap-threshold=") == 0) {
+			string value = argument.substr(17);
+
+			char * end;
+			size_t threshold = strtoul(value.c_str(), &end, 10);
+
+			if (value.empty() || *end) {
+				Console::ErrorStream() << "Invalid memory map threshold: '" << value << "'" << endl;
+				return 1;
+			}
 
-	void AppendToBuffer(std::string & s) {
-		buffer += s;
-	}
+			SourceFile::SetMemoryMapThreshold(threshold);
+		} else if (argument.compare(0, 13, "--max-memory=") == 0) {
+			string value = argument.substr(13);
 
-	void WriteBufferToHeader() {
-		if (buffer.size() > 0) {
-			header_file << buffer;
-			buffer.clear();
-		}
-	}
+			if (!ParseMemorySize(value, options.max_memory) || options.max_memory == 0) {
+				Console::ErrorStream() << "Invalid memory budget: '" << value << "'" << endl;
+				return 1;
+			}
+		} else if (argument == "-q") {
+			verbosity = Console::Verbosity::quiet;
+		} else if (argument == "--summary") {
+			verbosity = Console::Verbosity::summary;
+		} else if (argument == "--watch") {
+			watch = true;
+		} else if (argument == "--stats") {
+			print_statistics = true;
+		} else if (argument.compare(0, 8, "--stats=") == 0) {
+			string value = argument.substr(8);
+
+			char * end;
+			number_slowest_files = strtoul(value.c_str(), &end, 10);
+
+			if (value.empty() || *end) {
+				Console::ErrorStream() << "Invalid number of slowest files: '" << value << "'" << endl;
+				return 1;
+			}
 
-	void WriteBufferToCpp() {
-		if (buffer.size() > 0) {
-			cpp_file << buffer;
-			buffer.clear();
+			print_statistics = true;
+		} else if (argument.compare(0, 13, "--stats-json=") == 0 && argument.size() > 13) {
+			statistics_json_filename = argument.substr(13);
+		} else if (argument == "--help") {
+			PrintBanner();
+			PrintOptions();
+			return 0;
+		} else if (argument.size() > 1 && argument[0] == '-') {
+			Console::ErrorStream() << "Unknown option: " << argument << endl;
+			PrintOptions();
+			return 1;
+		} else {
+			base_dir = argv[a];
 		}
 	}
 
-	void WriteBufferToBoth() {
-		if (buffer.size() > 0) {
-			header_file << buffer;
-			cpp_file << buffer;
-			buffer.clear();
-		}
-	}
+	Console::SetVerbosity(verbosity);
+	PrintBanner();
 
-	void WriteToHeader(const std::string & s) {
-		WriteBufferToHeader();
-		header_file << s;
-	}
+	Parser::SetParallelParsing(options.number_threads);
 
-	void WriteToCpp(const std::string & s) {
-		WriteBufferToCpp();
-		cpp_file << s;
-	}
+#ifdef __GLIBC__
+	// By default, glibc raises the threshold from which blocks are memory mapped as large blocks are freed, keeping 
+	// them in the heap afterwards. A fixed threshold gives their memory back to the system, once they are freed.
+	if (options.max_memory > 0) mallopt(M_MMAP_THRESHOLD, 128 * 1024);
+#endif
 
+	boost::system::error_code error;
+	bool single_file = boost::filesystem::is_regular_file(base_dir, error);
 
-	void WriteToBoth(const std::string & s) {
-		WriteBufferToBoth();
-		header_file << s;
-		cpp_file << s;
+	if (single_file && watch) {
+		Console::ErrorStream() << "The option --watch can only be used with a directory" << endl;
+		return 1;
 	}
 
-	std::ofstream & HeaderFile() {
-		WriteBufferToHeader();
-		return header_file;
+	if (!single_file && (output_dir != nullptr || depfile != nullptr)) {
+		Console::ErrorStream() << "The options -o and --depfile can only be used with a single .cppx file" << endl;
+		return 1;
 	}
 
-	std::ofstream & CppFile() {
-		WriteBufferToCpp();
-		return cpp_file;
+	if (single_file && !options.dependency_graph.empty()) {
+		Console::ErrorStream() << "The option --deps-json can only be used with a directory (use --depfile instead)" << endl;
+		return 1;
 	}
-};
 
-/// Generates C++ code (.h and .cpp files) from a specific extended C++ file (.cppx)
-/// \param filename filename (.cppx) to process
-/// \sa GenerateCode
-void GenerateFileCode(const boost::filesystem::path & filename) {
-	using namespace boost::filesystem;
-
-	try {
-		Parser parser(filename);
-
-		auto code_blocks = parser.CodeBlocks();
-
-		if (code_blocks.empty()) {
-			Console::WarningStream() << "File " << filename << " does not contain any code to process" << endl;
-			return;
-		}
-
-		std::string header_filename = path(filename).replace_extension("h").string();
-		CodeWriter code_writer(path(filename).replace_extension("cpp").string(), header_filename);
-
-		auto code_block = code_blocks.cbegin();
-
-		if (code_block->type == Parser::CodeBlock::Type::comment) {
-			code_writer.WriteToBoth(code_block->ToString());
-			code_block++;
-		}
-
-		std::string include_guard = CodeGuardIdentifier(filename, code_blocks);
-
-		code_writer.HeaderFile() << "#ifndef " << include_guard << std::endl;
-		code_writer.HeaderFile() << "#define " << include_guard << std::endl << std::endl;
-
-		code_writer.CppFile() << "#include \"" << header_filename << '"' << std::endl << std::endl;
-
-		Parser::Container::Type next_container = Parser::Container::Type::none;
-		std::vector<Parser::Container> containers { Parser::Container(next_container) };
-		
-		while (++code_block != code_blocks.cend()) {
-			std::string current_code = code_block->ToString();
+	if (single_file && options.unity_files_per_unit > 0) {
+		Console::ErrorStream() << "The option --unity can only be used with a directory" << endl;
+		return 1;
+	}
 
-			auto ProcessContainer = [&] {
-				std::string identifier;
+	if (watch) return WatchCode(base_dir, options);
 
-				code_writer.AppendToBuffer(current_code);
+	if (print_statistics || !statistics_json_filename.empty() || verbosity == Console::Verbosity::summary) Statistics::Enable();
 
-				while (++code_block != code_blocks.cend()) {
-					current_code = code_block->ToString();
-					code_writer.AppendToBuffer(current_code);
+	// The output of the threads is only flushed from time to time (rather than after each message)
+	Console::SetBuffered(true);
 
-					switch (code_block->type) {
-						case Parser::CodeBlock::Type::identifier:
-							if (identifier.empty()) identifier = current_code;
-							break;
-
-						case Parser::CodeBlock::Type::begin_group:
-							containers.push_back(Parser::Container(identifier, next_container, 1));
-							code_writer.WriteBufferToHeader();
-							return;
-
-						case Parser::CodeBlock::Type::statement_terminator:
-							code_writer.WriteBufferToHeader();
-							return;
+	auto start = chrono::steady_clock::now();
+	int error_code = (single_file) ? GenerateSingleFileCode(base_dir, output_dir, depfile, options.forward_declarations) : GenerateCode(base_dir, options);
+	auto wall_time = chrono::steady_clock::now() - start;
 
-						default:
-							break;
-					}
-				}
-			};
+	Console::SetBuffered(false);
 
-			switch (code_block->type) {
-				case cppx::Parser::CodeBlock::Type::directive:
-				case cppx::Parser::CodeBlock::Type::access_modifier:
-					code_writer.WriteToHeader(current_code);
-					break;
-
-				case cppx::Parser::CodeBlock::Type::namespace_keyword:
-					next_container = Parser::Container::Type::namespace_container;
-					ProcessContainer();
-					break;
-
-				case cppx::Parser::CodeBlock::Type::class_keyword:
-					next_container = Parser::Container::Type::class_container;
-					ProcessContainer();
-					break;
-
-				case cppx::Parser::CodeBlock::Type::struct_keyword:
-					next_container = Parser::Container::Type::struct_container;
-					ProcessContainer();
-					break;
-
-				case cppx::Parser::CodeBlock::Type::enumeration:
-					next_container = Parser::Container::Type::enumeration;
-					ProcessContainer();
-					break;
-
-				case cppx::Parser::CodeBlock::Type::function_name:
-				case cppx::Parser::CodeBlock::Type::constructor_destructor:
-					{
-						[&] {
-							std::string function_name = current_code;
-							std::string function = current_code;
-							
-							while (++code_block != code_blocks.cend()) {
-								current_code = code_block->ToString();
-
-								switch (code_block->type) {
-									case Parser::CodeBlock::Type::begin_group:
-
-									case Parser::CodeBlock::Type::initialization_list:									
-										code_writer.WriteBufferToBoth();
-
-										// add the scope to cpp file
-										for (const auto & c : containers) {
-											if (c.name.size() > 0) code_writer.WriteToCpp(c.name + "::");
-										}
-
-										code_writer.WriteToBoth(function);
-
-										code_writer.HeaderFile() << ';';
-
-										code_writer.WriteToCpp(current_code);										
-
-										containers.push_back(Parser::Container(function_name, Parser::Container::Type::function, (code_block->type == Parser::CodeBlock::Type::begin_group) ? 1 : 0));
-
-										while (containers.back().type == Parser::Container::Type::function && ++code_block != code_blocks.cend()) {
-											code_writer.WriteToCpp(code_block->ToString());
-
-											switch (code_block->type) {
-												case Parser::CodeBlock::Type::begin_group:
-													containers.back().braces++;
-													break;
-
-												case Parser::CodeBlock::Type::end_group:
-													if (--(containers.back().braces) == 0) containers.pop_back();
-													break;
-
-												default:
-													break;
-											}
-										}
-
-										return;
-
-									case Parser::CodeBlock::Type::statement_terminator:
-										code_writer.WriteToHeader(function + current_code);
-										return;
-
-									default:
-										function += current_code;
-										break;
-								}
-							}
-						} ();
-					}
-					break;
-
-				case cppx::Parser::CodeBlock::Type::statement_terminator:
-					code_writer.WriteToHeader(current_code);
-					break;
-
-				case cppx::Parser::CodeBlock::Type::end_group:
-					code_writer.WriteToHeader(current_code);
-
-					if (--(containers.back().braces) == 0) {
-						if (containers.size() > 1) containers.pop_back();
-					}
-					break;
-
-				case cppx::Parser::CodeBlock::Type::begin_group:
-					code_writer.WriteToHeader(current_code);
-					containers.back().braces++;
-					break;
-
-				default:
-					code_writer.AppendToBuffer(current_code);
-					break;
-			}
-		}
+	if (verbosity == Console::Verbosity::summary) {
+		ostringstream summary;
+		Statistics::PrintSummary(summary, wall_time);
 
-		code_writer.HeaderFile() << std::endl << std::endl << "#endif // " << include_guard << std::endl << std::endl;
-	} catch (const Parser::Error & error) {
-		Console::ErrorStream() << "Error at " << filename << " (line " << error.Line() << "): ";
-		Console::ErrorStream() << error.what() << ": " << error.CodeContainingError() << std::endl;
-	}
-}
-
-/// Generates C++ code (.h and .cpp files) from all extended C++ files (.cppx) contained within the 
-/// \a base_dir directory and its subdirectories
-/// \param base_dir base directory for processing the .cppx files
-/// \return 0 if successfull. An error code otherwise.
-/// \sa GenerateFileCode
-int GenerateCode(const char * base_dir) {
-	using namespace boost::filesystem;
-
-	constexpr int OK_RESULT = 0;
-	constexpr int ERROR_RESULT = 1;
-
-	try {
-		if (!exists(base_dir) || !is_directory(base_dir)) {
-			Console::ErrorStream() << "Could not access directory: " << base_dir << endl;
-			return ERROR_RESULT;
-		}
-	} catch (const filesystem_error & exception) {
-		Console::ErrorStream() << "An error ocurred while accessing directory '" << base_dir << "': " << exception.what() << endl;
-		return ERROR_RESULT;
+		Console::SummaryStream() << summary.str();
 	}
 
-	Console::OutputStream() << "Processing directory: " << base_dir << endl;
+	if (print_statistics) {
+		ostringstream statistics;
+		Statistics::Print(statistics, wall_time, number_slowest_files);
 
-	vector<path> files_to_process = GetFilesToProcess(base_dir);
-
-	auto number_files_to_process = files_to_process.size();
-
-	if (files_to_process.size() == 0) {
-		Console::WarningStream() << "No extend C++ files (.cppx) found in '" << base_dir << "' or in its subdirectories" << endl;
-	} else {
-		Console::OutputStream() << "Found " << number_files_to_process << " files to process:" << endl;
-
-		for (const path & f : files_to_process) {
-			boost::system::error_code error;
-			auto size = file_size(f, error);
-
-			Console::OutputStream() << f;
-
-			if (!error) {
-				Console::OutputStream() << " (" << size << " bytes)";
-			}
+		Console::OutputStream() << endl << statistics.str();
+	}
 
-			Console::OutputStream() << endl;
+	if (!statistics_json_filename.empty()) {
+		ofstream statistics(statistics_json_filename);
+		Statistics::PrintJson(statistics, wall_time, number_slowest_files);
 
-			GenerateFileCode(f);
+		if (!statistics) {
+			Console::ErrorStream() << "Could not write the statistics to '" << statistics_json_filename << "'" << endl;
 		}
 	}
 
-	return OK_RESULT;
-}
-
-/// Main entry point for cppxgen tool
-/// Converts extended C++ files (.cppx) to standard C++ files (.h and .cpp).
-/// Usage: cppxgen [base directory (default current)]
-int main(int argc, char * argv[]) {
-	Console::OutputStream() << CPPX_VERSION_STRING << endl;
-	Console::OutputStream() << "Converts extended C++ files (.cppx) to standard C++ files (.h and .cpp)" << endl;
-	Console::OutputStream() << "Usage: cppxgen [base directory (default current)]" << endl;
-	Console::OutputStream() << endl;
-
-	int error_code = GenerateCode((argc < 2) ? "./" : argv[1]);
+	if (options.max_memory > 0) {
+		Console::OutputStream() << endl;
+		Console::OutputStream() << "Peak memory usage: " << MemorySize(Statistics::PeakMemoryUsage()) << " (budget: " << MemorySize(options.max_memory) << ")" << endl;
+	}
 
 	Console::OutputStream() << endl;
 	Console::OutputStream() << "Thank you for trying cppxgen." << endl;
@@ -0,0 +1,217 @@
+/*
+	Noel Lopes is a Professor at the Polytechnic of Guarda, Portugal
+	and a Researcher at the CISUC - University of Coimbra, Portugal
+	Copyright (C) 2017 Noel de Jesus Mendonça Lopes
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+#include "declarations.h"
+
+namespace cppx {
+	constexpr size_t Declarations::NONE;
+
+	void Declarations::Build(const Parser::CodeBlockList & code_blocks) {
+		typedef Parser::CodeBlock::Type BlockType;
+		typedef Declaration::Type Type;
+
+		this->code_blocks = &code_blocks;
+
+		declarations.clear();
+		directives.clear();
+		open.clear();
+
+		enum class State {
+			scope, // namespace, class, struct, enumeration, group (or outside all of them)
+			head, // between the keyword of a namespace, class, struct or enumeration and its '{' (or ';')
+			signature, // between the name of a function and its body (or ';')
+			function_body
+		};
+
+		State state = State::scope;
+		Declaration candidate; // declaration whose head (or signature) is being scanned
+		size_t braces = 0; // braces open in the body of the function
+		size_t previous = NONE;
+
+		auto Add = [&] (size_t body, bool has_body) {
+			candidate.body = body;
+			candidate.has_body = has_body;
+			candidate.complete = !has_body;
+			candidate.end = body + 1;
+			candidate.next = declarations.size() + 1;
+
+			declarations.push_back(candidate);
+		};
+
+		auto Open = [&] (size_t body) {
+			Add(body, true);
+			open.push_back(declarations.size() - 1);
+		};
+
+		auto Close = [&] (size_t declaration, size_t end, bool complete) {
+			declarations[declaration].end = end;
+			declarations[declaration].complete = complete;
+			declarations[declaration].next = declarations.size();
+		};
+
+		auto Begin = [&] (Type type, size_t begin) {
+			candidate.type = type;
+			candidate.begin = begin;
+			candidate.previous = previous;
+			candidate.name = boost::string_ref();
+		};
+
+		for (size_t b = 0; b < code_blocks.size(); ++b) {
+			const Parser::CodeBlock block = code_blocks[b];
+
+			if (block.type == BlockType::directive) directives.push_back(b);
+
+			// Heads and signatures that reach a '}' are not declarations (e.g. sizeof(int) in enum { n = sizeof(int) }), so the '}' closes the enclosing scope
+			if (block.type == BlockType::end_group && (state == State::head || state == State::signature)) state = State::scope;
+
+			switch (state) {
+				case State::scope:
+					switch (block.type) {
+						case BlockType::namespace_keyword:
+							Begin(Type::namespace_declaration, b);
+							state = State::head;
+							break;
+
+						case BlockType::class_keyword:
+							Begin(Type::class_declaration, b);
+							state = State::head;
+							break;
+
+						case BlockType::struct_keyword:
+							Begin(Type::struct_declaration, b);
+							state = State::head;
+							break;
+
+						case BlockType::enumeration:
+							Begin(Type::enumeration, b);
+							state = State::head;
+							break;
+
+						case BlockType::function_name:
+							Begin(Type::function, b);
+							candidate.name = block.View();
+							state = State::signature;
+							break;
+
+						case BlockType::constructor_destructor:
+							Begin(Type::constructor_destructor, b);
+							candidate.name = block.View();
+							state = State::signature;
+							break;
+
+						case BlockType::begin_group:
+							Begin(Type::group, b);
+							Open(b);
+							break;
+
+						case BlockType::end_group:
+							if (!open.empty()) {
+								Close(open.back(), b + 1, true);
+								open.pop_back();
+							}
+							break;
+
+						default:
+							break;
+					}
+					break;
+
+				case State::head:
+					if (block.type == BlockType::identifier) {
+						if (candidate.name.empty()) candidate.name = block.View();
+					} else if (block.type == BlockType::begin_group) {
+						Open(b);
+						state = State::scope;
+					} else if (block.type == BlockType::statement_terminator) {
+						Add(b, false);
+						state = State::scope;
+					}
+					break;
+
+				case State::signature:
+					if (block.type == BlockType::begin_group || block.type == BlockType::initialization_list) {
+						Add(b, true);
+						braces = (block.type == BlockType::begin_group) ? 1 : 0;
+						state = State::function_body;
+					} else if (block.type == BlockType::statement_terminator) {
+						Add(b, false);
+						state = State::scope;
+					}
+					break;
+
+				case State::function_body:
+					if (block.type == BlockType::begin_group) {
+						braces++;
+					} else if (block.type == BlockType::end_group) {
+						if (braces == 0) {
+							// '}' after an initialization list, without a body: it closes the enclosing scope
+							Close(declarations.size() - 1, b, false);
+							state = State::scope;
+							--b;
+							continue;
+						}
+
+						if (--braces == 0) {
+							Close(declarations.size() - 1, b + 1, true);
+							state = State::scope;
+						}
+					}
+					break;
+			}
+
+			if (block.type != BlockType::empty && block.type != BlockType::comment) previous = b;
+		}
+
+		// The code may end before the bodies are closed (heads and signatures not terminated are not declarations)
+		if (state == State::function_body) Close(declarations.size() - 1, code_blocks.size(), false);
+
+		while (!open.empty()) {
+			Close(open.back(), code_blocks.size(), false);
+			open.pop_back();
+		}
+	}
+
+	void Declarations::Emit(DeclarationEmitter & emitter) const {
+		size_t declaration = 0;
+
+		if (code_blocks != nullptr) Emit(declaration, 0, code_blocks->size(), emitter);
+	}
+
+	// Emits the code blocks [begin, end) and the declarations they contain, which begin at declaration (advanced past them)
+	void Declarations::Emit(size_t & declaration, size_t begin, size_t end, DeclarationEmitter & emitter) const {
+		size_t block = begin;
+
+		while (declaration < declarations.size() && declarations[declaration].begin < end) {
+			const Declaration & current = declarations[declaration];
+
+			if (block < current.begin) emitter.Code(*this, block, current.begin);
+
+			if (emitter.Enter(*this, current)) {
+				++declaration;
+				if (current.has_body) Emit(declaration, current.body + 1, (current.complete) ? current.end - 1 : current.end, emitter);
+
+				emitter.Leave(*this, current);
+			}
+
+			declaration = current.next;
+			block = current.end;
+		}
+
+		if (block < end) emitter.Code(*this, block, end);
+	}
+}
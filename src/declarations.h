@@ -0,0 +1,141 @@
+/*
+	Noel Lopes is a Professor at the Polytechnic of Guarda, Portugal
+	and a Researcher at the CISUC - University of Coimbra, Portugal
+	Copyright (C) 2017 Noel de Jesus Mendonça Lopes
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+#ifndef CPPX_DECLARATIONS_H
+#define CPPX_DECLARATIONS_H
+
+#include <cstddef>
+#include <vector>
+
+#include <boost/utility/string_ref.hpp>
+
+#include "parser.h"
+
+namespace cppx {
+
+	class DeclarationEmitter;
+
+	/// Compact tree of the declarations of an extended C++ file (namespaces, classes, structs, 
+	/// enumerations, functions and constructors/destructors), built in a single pass over the 
+	/// code blocks of the Parser. The outputs of the file (header, source, forward declarations, ...) 
+	/// are generated by emitters that walk the tree (see Emit), instead of each one scanning the code blocks.
+	/// Declarations refer to the code blocks by their index, so the code blocks must outlive the tree.
+	class Declarations {
+	public:
+		/// Value of the indexes that do not refer to any code block.
+		static constexpr size_t NONE = static_cast<size_t>(-1);
+
+		/// Declaration (or group of code between braces that is not a declaration).
+		/// Declarations are stored in pre-order, so the declarations nested in 
+		/// a declaration are those that follow it, up to (but excluding) next.
+		struct Declaration {
+			enum class Type : unsigned char {
+				namespace_declaration,
+				class_declaration,
+				struct_declaration,
+				enumeration,
+				function,
+				constructor_destructor,
+				group // code between braces (e.g. an initializer), whose declarations belong to the enclosing scope
+			};
+
+			Type type;
+			bool has_body; // whether the declaration is followed by a body (otherwise it is terminated by a ';')
+			bool complete; // whether the body is closed (or the ';' was found) before the end of the code
+
+			size_t begin; // first code block (the keyword, the name of the function or the '{' of a group)
+			size_t body; // code block that begins the body ('{' or the initialization list of a constructor) or the ';' that terminates the declaration
+			size_t end; // one past the last code block (the '}' that closes the body or the ';')
+			size_t previous; // last code block, before begin, that is not empty nor a comment (NONE if there is none)
+			size_t next; // index of the next declaration that is not nested in this one
+
+			boost::string_ref name; // first identifier of namespaces, classes, structs and enumerations, name of functions (empty if anonymous)
+
+			/// Returns whether the declaration is a namespace, class, struct or enumeration.
+			bool IsContainer() const {
+				return type != Type::function && type != Type::constructor_destructor && type != Type::group;
+			}
+
+			/// Returns whether the declaration is a function or a constructor/destructor.
+			bool IsFunction() const {
+				return type == Type::function || type == Type::constructor_destructor;
+			}
+		};
+
+		Declarations() : code_blocks(nullptr) {}
+
+		/// Builds the tree of declarations of the code blocks, replacing the previous one. 
+		/// The storage of the previous tree is reused (see GenerationContext).
+		/// Function bodies are not scanned for declarations: they are kept as a whole.
+		/// \param code_blocks Code blocks of an extended C++ file (see Parser::CodeBlocks).
+		void Build(const Parser::CodeBlockList & code_blocks);
+
+		/// Walks the tree, in the order of the code, calling the emitter for each declaration 
+		/// and for each sequence of code blocks that does not belong to any declaration.
+		void Emit(DeclarationEmitter & emitter) const;
+
+		const Parser::CodeBlockList & CodeBlocks() const {
+			return *code_blocks;
+		}
+
+		/// Returns the declarations, in pre-order (see Declaration::next).
+		const std::vector<Declaration> & All() const {
+			return declarations;
+		}
+
+		/// Returns the indexes of the directive code blocks (including those within function bodies).
+		const std::vector<size_t> & Directives() const {
+			return directives;
+		}
+
+		/// Returns a view of the code in the code blocks [begin, end).
+		boost::string_ref View(size_t begin, size_t end) const {
+			if (begin >= end) return boost::string_ref();
+
+			const char * code = (*code_blocks)[begin].begin;
+			return boost::string_ref(code, (*code_blocks)[end - 1].end + 1 - code);
+		}
+
+	private:
+		const Parser::CodeBlockList * code_blocks;
+		std::vector<Declaration> declarations;
+		std::vector<size_t> directives;
+		std::vector<size_t> open; // declarations whose body has not been closed yet (while building)
+
+		void Emit(size_t & declaration, size_t begin, size_t end, DeclarationEmitter & emitter) const;
+	};
+
+	/// Generates an output (e.g. the header or the source file) from the declarations of a file (see Declarations::Emit).
+	class DeclarationEmitter {
+	public:
+		virtual ~DeclarationEmitter() {}
+
+		/// Called for each sequence of code blocks [begin, end) that does not belong to any declaration 
+		/// (either outside all the declarations or in the body of a declaration, between its nested declarations).
+		virtual void Code(const Declarations & declarations, size_t begin, size_t end) {}
+
+		/// Called when a declaration is found.
+		/// \return Whether the body of the declaration (its nested declarations and code) is visited. If so, Leave is called afterwards.
+		virtual bool Enter(const Declarations & declarations, const Declarations::Declaration & declaration) { return false; }
+
+		/// Called after visiting the body of a declaration (when Enter returns true).
+		virtual void Leave(const Declarations & declarations, const Declarations::Declaration & declaration) {}
+	};
+}
+
+#endif // CPPX_DECLARATIONS_H
@@ -0,0 +1,168 @@
+/*
+	Noel Lopes is a Professor at the Polytechnic of Guarda, Portugal
+	and a Researcher at the CISUC - University of Coimbra, Portugal
+	Copyright (C) 2017 Noel de Jesus Mendonça Lopes
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+#include <cstddef>
+#include <cstring>
+
+#include "dependencies.h"
+#include "json.h"
+#include "scanner.h"
+
+namespace cppx {
+	namespace {
+		// Escapes the characters that have a special meaning in Makefile rules
+		std::string MakeEscaped(const std::string & filename) {
+			std::string result;
+
+			for (char c : filename) {
+				switch (c) {
+					case ' ':
+					case '#':
+					case '\\':
+						result += '\\';
+						break;
+
+					case '$':
+						result += '$';
+						break;
+				}
+
+				result += c;
+			}
+
+			return result;
+		}
+
+		// Returns the include of a directive line (#include "...") or an empty string_ref if there is none
+		boost::string_ref LocalInclude(const char * line, const char * end) {
+			constexpr size_t INCLUDE_LENGTH = 7; // strlen("include")
+
+			const char * c = line;
+
+			while (c < end && Scanner::IsWhiteSpace(*c)) ++c;
+			if (c == end || *c++ != '#') return boost::string_ref();
+
+			while (c < end && Scanner::IsWhiteSpace(*c)) ++c;
+			if (end - c < static_cast<ptrdiff_t>(INCLUDE_LENGTH) || memcmp(c, "include", INCLUDE_LENGTH) != 0) return boost::string_ref();
+			c += INCLUDE_LENGTH;
+
+			while (c < end && Scanner::IsWhiteSpace(*c)) ++c;
+			if (c == end || *c++ != '"') return boost::string_ref();
+
+			const char * include = c;
+			while (c < end && *c != '"') ++c;
+
+			if (c == end || c == include) return boost::string_ref();
+
+			return boost::string_ref(include, c - include);
+		}
+
+		// Adds the local includes of a directive block, which may contain several lines (e.g. consecutive directives)
+		void AddLocalIncludes(const Parser::CodeBlock & block, std::vector<std::string> & includes) {
+			for (const char * line = block.begin; line < block.end;) {
+				const char * line_end = static_cast<const char *>(memchr(line, '\n', block.end - line));
+				if (line_end == nullptr) line_end = block.end;
+
+				boost::string_ref include = LocalInclude(line, line_end);
+				if (!include.empty()) includes.push_back(include.to_string());
+
+				line = line_end + 1;
+			}
+		}
+	}
+
+	void FindLocalIncludes(const Parser::CodeBlockList & code_blocks, std::vector<std::string> & includes) {
+		includes.clear();
+
+		for (const auto & block : code_blocks) {
+			if (block.type == Parser::CodeBlock::Type::directive) AddLocalIncludes(block, includes);
+		}
+	}
+
+	void FindLocalIncludes(const Declarations & declarations, std::vector<std::string> & includes) {
+		includes.clear();
+
+		for (size_t directive : declarations.Directives()) AddLocalIncludes(declarations.CodeBlocks()[directive], includes);
+	}
+
+	boost::filesystem::path ResolveInclude(const boost::filesystem::path & source, const std::string & include, boost::filesystem::path & generated_from) {
+		using namespace boost::filesystem;
+
+		path included = source.parent_path() / include;
+
+		generated_from = included;
+		generated_from.replace_extension(".cppx");
+
+		boost::system::error_code error;
+		if (included.extension() == ".cppx" || !is_regular_file(generated_from, error)) generated_from.clear();
+
+		return included;
+	}
+
+	void WriteDepfile(std::ostream & os, const FileDependencies & dependencies) {
+		using namespace boost::filesystem;
+
+		os << MakeEscaped(dependencies.header) << ' ' << MakeEscaped(dependencies.cpp) << ": " << MakeEscaped(dependencies.source.string());
+
+		for (const auto & include : dependencies.includes) {
+			path generated_from;
+			path included = ResolveInclude(dependencies.source, include, generated_from);
+
+			boost::system::error_code error;
+
+			if (!generated_from.empty()) {
+				os << " \\\n  " << MakeEscaped(generated_from.string());
+			} else if (is_regular_file(included, error)) {
+				os << " \\\n  " << MakeEscaped(included.string());
+			}
+		}
+
+		os << '\n';
+	}
+
+	void WriteDependencyGraph(std::ostream & os, const std::vector<FileDependencies> & files) {
+		using namespace boost::filesystem;
+
+		os << "{\n";
+		os << "\t\"files\": [";
+
+		for (size_t f = 0; f < files.size(); ++f) {
+			const FileDependencies & file = files[f];
+
+			os << ((f == 0) ? "\n" : ",\n") << "\t\t{\n";
+			os << "\t\t\t\"source\": " << JsonString(file.source.string()) << ",\n";
+			os << "\t\t\t\"outputs\": [ " << JsonString(file.header) << ", " << JsonString(file.cpp) << " ],\n";
+			os << "\t\t\t\"includes\": [";
+
+			for (size_t i = 0; i < file.includes.size(); ++i) {
+				path generated_from;
+				path included = ResolveInclude(file.source, file.includes[i], generated_from);
+
+				os << ((i == 0) ? "\n" : ",\n") << "\t\t\t\t{ \"include\": " << JsonString(file.includes[i]) << ", \"path\": " << JsonString(included.string());
+				if (!generated_from.empty()) os << ", \"generated_from\": " << JsonString(generated_from.string());
+				os << " }";
+			}
+
+			os << ((file.includes.empty()) ? "]\n" : "\n\t\t\t]\n");
+			os << "\t\t}";
+		}
+
+		os << ((files.empty()) ? "]\n" : "\n\t]\n");
+		os << "}\n";
+	}
+}
@@ -0,0 +1,78 @@
+/*
+	Noel Lopes is a Professor at the Polytechnic of Guarda, Portugal
+	and a Researcher at the CISUC - University of Coimbra, Portugal
+	Copyright (C) 2017 Noel de Jesus Mendonça Lopes
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+#ifndef CPPX_DEPENDENCIES_H
+#define CPPX_DEPENDENCIES_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "declarations.h"
+#include "parser.h"
+
+namespace cppx {
+
+	/// Local includes (#include "...") of an extended C++ file (.cppx), which the build 
+	/// system can not see until the generated files are compiled (see WriteDepfile and WriteDependencyGraph).
+	struct FileDependencies {
+		boost::filesystem::path source; // extended C++ file (.cppx)
+		std::string header; // generated header file (.h)
+		std::string cpp; // generated source file (.cpp)
+		std::vector<std::string> includes; // local includes, as written in the directives
+
+		FileDependencies() = default;
+
+		FileDependencies(const boost::filesystem::path & source, const std::string & header, const std::string & cpp, const std::vector<std::string> & includes) :
+			source(source), header(header), cpp(cpp), includes(includes) {}
+	};
+
+	/// Finds the local includes (#include "...") in the directives of the code.
+	/// \param code_blocks Code blocks of an extended C++ file (see Parser).
+	/// \param includes Vector where the includes found are stored (its previous contents are discarded).
+	void FindLocalIncludes(const Parser::CodeBlockList & code_blocks, std::vector<std::string> & includes);
+
+	/// Finds the local includes (#include "...") in the directives of the code, recorded by its declarations.
+	/// \param declarations Declarations of an extended C++ file (see Declarations::Directives).
+	/// \param includes Vector where the includes found are stored (its previous contents are discarded).
+	void FindLocalIncludes(const Declarations & declarations, std::vector<std::string> & includes);
+
+	/// Resolves a local include, relative to the directory of the file that includes it.
+	/// \param source File containing the include.
+	/// \param include Include, as written in the directive.
+	/// \param generated_from Set to the extended C++ file (.cppx) from which the included file is generated (if any). Otherwise, it is cleared.
+	/// \return The included file (which may not exist yet, namely when it is generated).
+	boost::filesystem::path ResolveInclude(const boost::filesystem::path & source, const std::string & include, boost::filesystem::path & generated_from);
+
+	/// Writes a Makefile (and Ninja) style depfile, stating that the generated files depend on 
+	/// the extended C++ file (.cppx) and on its local includes. The headers that are generated 
+	/// from other .cppx files are replaced by those files. Includes that can not be found are omitted.
+	/// \param os Stream where the depfile is written.
+	/// \param dependencies Dependencies of the extended C++ file.
+	void WriteDepfile(std::ostream & os, const FileDependencies & dependencies);
+
+	/// Writes the dependency graph (JSON) of a set of extended C++ files (.cppx): for each file, 
+	/// the generated files and the local includes (resolved, see ResolveInclude).
+	/// \param os Stream where the graph is written.
+	/// \param files Dependencies of the extended C++ files.
+	void WriteDependencyGraph(std::ostream & os, const std::vector<FileDependencies> & files);
+}
+
+#endif // CPPX_DEPENDENCIES_H
@@ -0,0 +1,358 @@
+/*
+	Noel Lopes is a Professor at the Polytechnic of Guarda, Portugal
+	and a Researcher at the CISUC - University of Coimbra, Portugal
+	Copyright (C) 2017 Noel de Jesus Mendonça Lopes
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+#include "console.h"
+#include "file_discovery.h"
+
+#ifdef BOOST_POSIX_API
+	#include <dirent.h>
+	#include <sys/stat.h>
+#endif
+
+namespace cppx {
+	bool GlobMatches(const char * pattern, const char * text) {
+		for (;;) {
+			switch (*pattern) {
+				case 0:
+					return *text == 0;
+
+				case '*':
+					if (pattern[1] == '*') {
+						const char * rest = pattern + 2;
+
+						// "**/" also matches zero directories
+						if (*rest == '/' && GlobMatches(rest + 1, text)) return true;
+
+						for (const char * t = text; ; ++t) {
+							if (GlobMatches(rest, t)) return true;
+							if (!*t) return false;
+						}
+					}
+
+					for (const char * t = text; ; ++t) {
+						if (GlobMatches(pattern + 1, t)) return true;
+						if (!*t || *t == '/') return false;
+					}
+
+				case '?':
+					if (!*text || *text == '/') return false;
+					++pattern;
+					++text;
+					break;
+
+				case '[':
+					{
+						const char * p = pattern + 1;
+
+						bool negate = (*p == '!' || *p == '^');
+						if (negate) ++p;
+
+						bool matched = false;
+						unsigned char c = static_cast<unsigned char>(*text);
+
+						for (const char * first = p; *p && (*p != ']' || p == first);) {
+							unsigned char low = static_cast<unsigned char>(*p);
+							unsigned char high = low;
+
+							if (p[1] == '-' && p[2] && p[2] != ']') {
+								high = static_cast<unsigned char>(p[2]);
+								p += 3;
+							} else {
+								++p;
+							}
+
+							if (c >= low && c <= high) matched = true;
+						}
+
+						if (*p == ']') {
+							if (!*text || *text == '/' || matched == negate) return false;
+
+							pattern = p + 1;
+							++text;
+							break;
+						}
+					}
+
+					// Not a character class: '[' is matched literally
+					if (*text != '[') return false;
+					++pattern;
+					++text;
+					break;
+
+				case '\\':
+					if (pattern[1]) ++pattern;
+					if (*pattern != *text) return false;
+					++pattern;
+					++text;
+					break;
+
+				default:
+					if (*pattern != *text) return false;
+					++pattern;
+					++text;
+					break;
+			}
+		}
+	}
+
+	constexpr const char * ExclusionList::IGNORE_FILENAME;
+
+	ExclusionList::ExclusionList() {
+		for (const char * directory : { ".git/", ".hg/", ".svn/" }) Add(directory);
+	}
+
+	ExclusionList::ExclusionList(const boost::filesystem::path & base_dir, const std::vector<std::string> & patterns) : ExclusionList() {
+		std::ifstream ignore_file((base_dir / IGNORE_FILENAME).string());
+
+		for (std::string line; std::getline(ignore_file, line);) {
+			if (!line.empty() && line[0] == '!') {
+				Console::WarningStream() << "Negated patterns are not supported (" << IGNORE_FILENAME << "): " << line << std::endl;
+				continue;
+			}
+
+			Add(line);
+		}
+
+		for (const auto & pattern : patterns) Add(pattern);
+	}
+
+	void ExclusionList::Add(std::string pattern) {
+		while (!pattern.empty() && isspace(static_cast<unsigned char>(pattern.back()))) pattern.pop_back();
+
+		if (pattern.empty() || pattern[0] == '#') return;
+
+		Pattern p;
+
+		p.directories_only = (pattern.back() == '/');
+		if (p.directories_only) pattern.pop_back();
+
+		p.match_path = (pattern.find('/') != std::string::npos);
+		if (!pattern.empty() && pattern[0] == '/') pattern.erase(0, 1);
+
+		if (pattern.empty()) return;
+
+		p.glob = std::move(pattern);
+		patterns.push_back(std::move(p));
+	}
+
+	bool ExclusionList::Excludes(const std::string & relative_path, const char * name, bool is_directory) const {
+		for (const auto & p : patterns) {
+			if (p.directories_only && !is_directory) continue;
+			if (GlobMatches(p.glob.c_str(), (p.match_path) ? relative_path.c_str() : name)) return true;
+		}
+
+		return false;
+	}
+
+	bool ExclusionList::ExcludesFile(const boost::filesystem::path & base_dir, const boost::filesystem::path & filename) const {
+		std::string base = base_dir.generic_string();
+		std::string file = filename.generic_string();
+
+		if (file.compare(0, base.size(), base) != 0) return false;
+
+		size_t begin = base.size();
+		while (begin < file.size() && file[begin] == '/') ++begin;
+
+		std::string relative_path = file.substr(begin);
+
+		for (size_t b = 0; b < relative_path.size();) {
+			size_t e = relative_path.find('/', b);
+			bool is_directory = (e != std::string::npos);
+			if (!is_directory) e = relative_path.size();
+
+			std::string name = relative_path.substr(b, e - b);
+			if (Excludes(relative_path.substr(0, e), name.c_str(), is_directory)) return true;
+
+			b = e + 1;
+		}
+
+		return false;
+	}
+
+	namespace {
+		// Reads the directories of a tree in parallel. Each worker takes a directory 
+		// from the pending ones, reads it and adds its subdirectories to the pending ones.
+		class DirectoryWalker {
+		private:
+			struct Directory {
+				boost::filesystem::path path;
+				std::string relative_path;
+			};
+
+			const std::string & extension;
+			const ExclusionList & exclusions;
+
+			std::mutex mutex;
+			std::condition_variable directories_available;
+			std::deque<Directory> pending;
+			size_t active_workers;
+
+			bool HasExtension(const char * name) const {
+				size_t length = strlen(name);
+				return length >= extension.size() && extension.compare(0, extension.size(), name + length - extension.size()) == 0;
+			}
+
+			std::string RelativePath(const Directory & directory, const char * name) const {
+				return (directory.relative_path.empty()) ? std::string(name) : directory.relative_path + '/' + name;
+			}
+
+			// Classifies an entry of a directory, adding it to the files or to the subdirectories
+			void AddEntry(const Directory & directory, const char * name, bool is_directory, bool is_file, std::vector<boost::filesystem::path> & files, std::vector<Directory> & subdirectories) {
+				if (is_directory) {
+					std::string relative_path = RelativePath(directory, name);
+					if (!exclusions.Excludes(relative_path, name, true)) subdirectories.push_back(Directory { directory.path / name, std::move(relative_path) });
+				} else if (is_file) {
+					if (!exclusions.Excludes(RelativePath(directory, name), name, false)) files.push_back(directory.path / name);
+				}
+			}
+
+		#ifdef BOOST_POSIX_API
+			void ReadDirectory(const Directory & directory, std::vector<boost::filesystem::path> & files, std::vector<Directory> & subdirectories) {
+				DIR * dir = opendir(directory.path.c_str());
+
+				if (dir == nullptr) {
+					ReportError(directory.path, boost::system::error_code(errno, boost::system::generic_category()));
+					return;
+				}
+
+				while (dirent * entry = readdir(dir)) {
+					const char * name = entry->d_name;
+					if (name[0] == '.' && (name[1] == 0 || (name[1] == '.' && name[2] == 0))) continue;
+
+					unsigned char type = entry->d_type;
+					bool is_directory = (type == DT_DIR);
+					bool is_file = (type == DT_REG) && HasExtension(name);
+
+					if (type == DT_UNKNOWN || (type == DT_LNK && HasExtension(name))) {
+						// The type is not known or the entry is a symbolic link (to a file or to a directory)
+						std::string filename = (directory.path / name).string();
+						struct stat status;
+
+						if (type == DT_UNKNOWN && lstat(filename.c_str(), &status) == 0 && !S_ISLNK(status.st_mode)) {
+							is_directory = S_ISDIR(status.st_mode);
+							is_file = S_ISREG(status.st_mode) && HasExtension(name);
+						} else {
+							is_file = HasExtension(name) && stat(filename.c_str(), &status) == 0 && S_ISREG(status.st_mode);
+						}
+					}
+
+					AddEntry(directory, name, is_directory, is_file, files, subdirectories);
+				}
+
+				closedir(dir);
+			}
+		#else
+			void ReadDirectory(const Directory & directory, std::vector<boost::filesystem::path> & files, std::vector<Directory> & subdirectories) {
+				using namespace boost::filesystem;
+
+				boost::system::error_code error;
+				directory_iterator entry(directory.path, error), end;
+
+				for (; !error && entry != end; entry.increment(error)) {
+					std::string name = entry->path().filename().string();
+
+					file_status status = entry->symlink_status(error);
+					if (error) break;
+
+					boost::system::error_code link_error;
+					bool entry_is_directory = is_directory(status);
+					bool entry_is_file = HasExtension(name.c_str()) && ((is_symlink(status)) ? is_regular_file(entry->path(), link_error) : is_regular_file(status));
+
+					AddEntry(directory, name.c_str(), entry_is_directory, entry_is_file, files, subdirectories);
+				}
+
+				if (error) ReportError(directory.path, error);
+			}
+		#endif
+
+			void ReportError(const boost::filesystem::path & directory, const boost::system::error_code & error) {
+				boost::filesystem::filesystem_error exception("Could not read directory", directory, error);
+				Console::ErrorStream() << "An error ocurred while obtaining the files to process: " << exception.what() << std::endl;
+			}
+
+			void Work(std::vector<boost::filesystem::path> & files) {
+				std::vector<Directory> subdirectories;
+				std::unique_lock<std::mutex> lock(mutex);
+
+				for (;;) {
+					directories_available.wait(lock, [this] { return !pending.empty() || active_workers == 0; });
+					if (pending.empty()) return;
+
+					Directory directory = std::move(pending.front());
+					pending.pop_front();
+					++active_workers;
+
+					lock.unlock();
+					ReadDirectory(directory, files, subdirectories);
+					lock.lock();
+
+					for (auto & d : subdirectories) pending.push_back(std::move(d));
+					subdirectories.clear();
+
+					if (--active_workers == 0 || !pending.empty()) directories_available.notify_all();
+				}
+			}
+
+		public:
+			DirectoryWalker(const std::string & extension, const ExclusionList & exclusions) :
+				extension(extension), exclusions(exclusions), active_workers(0) {}
+
+			std::vector<boost::filesystem::path> Walk(const boost::filesystem::path & base_dir, size_t number_threads) {
+				pending.push_back(Directory { base_dir, std::string() });
+
+				if (number_threads == 0) number_threads = 1;
+
+				std::vector<std::vector<boost::filesystem::path>> files(number_threads);
+				std::vector<std::thread> workers;
+
+				for (size_t w = 1; w < number_threads; ++w) {
+					workers.push_back(std::thread([this, w, &files] { Work(files[w]); }));
+				}
+
+				Work(files[0]);
+
+				for (auto & worker : workers) worker.join();
+
+				for (size_t w = 1; w < number_threads; ++w) {
+					files[0].insert(files[0].end(), files[w].begin(), files[w].end());
+				}
+
+				return std::move(files[0]);
+			}
+		};
+	}
+
+	std::vector<boost::filesystem::path> FindFiles(const boost::filesystem::path & base_dir, const std::string & extension, const ExclusionList & exclusions, size_t number_threads) {
+		DirectoryWalker walker(extension, exclusions);
+		std::vector<boost::filesystem::path> files = walker.Walk(base_dir, number_threads);
+
+		std::sort(files.begin(), files.end());
+
+		return files;
+	}
+}
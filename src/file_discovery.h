@@ -0,0 +1,91 @@
+/*
+	Noel Lopes is a Professor at the Polytechnic of Guarda, Portugal
+	and a Researcher at the CISUC - University of Coimbra, Portugal
+	Copyright (C) 2017 Noel de Jesus Mendonça Lopes
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+#ifndef CPPX_FILE_DISCOVERY_H
+#define CPPX_FILE_DISCOVERY_H
+
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+namespace cppx {
+
+	/// Returns whether \a text matches a glob \a pattern. Besides regular characters, the pattern can contain 
+	/// '*' (any sequence of characters, except '/'), '**' (any sequence of characters, including '/'), 
+	/// '?' (any character, except '/'), character classes ([abc], [a-z] or [!abc]) and '\\' (escapes the next character).
+	bool GlobMatches(const char * pattern, const char * text);
+
+	/// Glob patterns of the files and directories excluded from the discovery of the files to process.
+	/// Patterns follow (a subset of) the .gitignore syntax: a pattern without a '/' is matched against 
+	/// the names of the files and directories (at any depth), while a pattern containing a '/' is matched 
+	/// against the path relative to the base directory (a leading '/' is ignored). A trailing '/' restricts 
+	/// the pattern to directories. Excluding a directory excludes all its contents.
+	class ExclusionList {
+	public:
+		/// Name of the file, in the base directory, containing patterns to exclude (one per line,
+		/// empty lines and lines starting with '#' are ignored).
+		static constexpr const char * IGNORE_FILENAME = ".cppxignore";
+
+	private:
+		struct Pattern {
+			std::string glob;
+			bool match_path;
+			bool directories_only;
+		};
+
+		std::vector<Pattern> patterns;
+
+	public:
+		/// Creates a list that excludes the version control directories (.git, .hg and .svn).
+		ExclusionList();
+
+		/// Creates a list that excludes the version control directories, the patterns 
+		/// of the ignore file (.cppxignore) of \a base_dir (if it exists) and the given patterns.
+		/// \param base_dir Base directory.
+		/// \param patterns Additional patterns to exclude.
+		ExclusionList(const boost::filesystem::path & base_dir, const std::vector<std::string> & patterns);
+
+		/// Adds a pattern to the list.
+		void Add(std::string pattern);
+
+		/// Returns whether a file or directory is excluded.
+		/// \param relative_path Path (relative to the base directory, using '/' as separator).
+		/// \param name Name of the file or directory (last component of \a relative_path).
+		/// \param is_directory Whether the path is a directory.
+		bool Excludes(const std::string & relative_path, const char * name, bool is_directory) const;
+
+		/// Returns whether a file, or any of the directories containing it, is excluded.
+		/// \param base_dir Base directory.
+		/// \param filename File within the base directory.
+		bool ExcludesFile(const boost::filesystem::path & base_dir, const boost::filesystem::path & filename) const;
+	};
+
+	/// Finds the files, with a given extension, contained within a directory and its subdirectories.
+	/// The directory entries are classified using the type returned when reading the directories (avoiding 
+	/// a stat per entry, whenever possible) and the subdirectories are read in parallel. Symbolic links to 
+	/// files are followed, but symbolic links to directories are not. Errors are reported on the console.
+	/// \param base_dir Directory where to look for the files.
+	/// \param extension Extension of the files (e.g. ".cppx").
+	/// \param exclusions Files and directories to exclude.
+	/// \param number_threads Number of threads used to read the directories.
+	/// \return The files found (sorted).
+	std::vector<boost::filesystem::path> FindFiles(const boost::filesystem::path & base_dir, const std::string & extension, const ExclusionList & exclusions, size_t number_threads);
+}
+
+#endif // CPPX_FILE_DISCOVERY_H
@@ -0,0 +1,224 @@
+/*
+	Noel Lopes is a Professor at the Polytechnic of Guarda, Portugal
+	and a Researcher at the CISUC - University of Coimbra, Portugal
+	Copyright (C) 2017 Noel de Jesus Mendonça Lopes
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+#include <cerrno>
+#include <chrono>
+#include <thread>
+#include <unordered_map>
+
+#include "file_watcher.h"
+
+#if defined(__linux__)
+	#define CPPX_WATCHER_INOTIFY
+	#include <poll.h>
+	#include <sys/inotify.h>
+	#include <unistd.h>
+#endif
+
+namespace cppx {
+	namespace {
+		const char EXTENDED_CPP_EXTENSION[] = ".cppx";
+
+		bool IsExtendedCppFile(const boost::filesystem::path & filename) {
+			return filename.extension() == EXTENDED_CPP_EXTENSION;
+		}
+	}
+
+#ifdef CPPX_WATCHER_INOTIFY
+	class FileWatcher::Implementation {
+	private:
+		static constexpr uint32_t DIRECTORY_EVENTS = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+		int fd;
+		std::unordered_map<int, boost::filesystem::path> directories;
+
+		// Watches a directory and its subdirectories. The .cppx files found are 
+		// reported as modified, since they could have been created before the 
+		// directory was being watched.
+		void WatchDirectory(const boost::filesystem::path & directory, std::vector<Change> * changes) {
+			using namespace boost::filesystem;
+
+			int wd = inotify_add_watch(fd, directory.c_str(), DIRECTORY_EVENTS);
+			if (wd < 0) return;
+
+			directories[wd] = directory;
+
+			boost::system::error_code error;
+			for (directory_iterator entry(directory, error), end; !error && entry != end; entry.increment(error)) {
+				file_status status = entry->symlink_status(error);
+				if (error) break;
+
+				if (is_directory(status)) {
+					WatchDirectory(entry->path(), changes);
+				} else if (changes != nullptr && IsExtendedCppFile(entry->path())) {
+					changes->push_back(Change(Change::Type::modified, entry->path()));
+				}
+			}
+		}
+
+	public:
+		explicit Implementation(const boost::filesystem::path & base_dir) {
+			fd = inotify_init1(IN_CLOEXEC);
+
+			if (fd < 0) {
+				throw boost::filesystem::filesystem_error("Could not watch directory", base_dir, boost::system::error_code(errno, boost::system::generic_category()));
+			}
+
+			WatchDirectory(base_dir, nullptr);
+
+			if (directories.empty()) {
+				close(fd);
+				throw boost::filesystem::filesystem_error("Could not watch directory", base_dir, boost::system::error_code(EACCES, boost::system::generic_category()));
+			}
+		}
+
+		~Implementation() {
+			close(fd);
+		}
+
+		bool WaitForChanges(std::vector<Change> & changes, int timeout_milliseconds) {
+			size_t initial_changes = changes.size();
+
+			pollfd poll_fd = { fd, POLLIN, 0 };
+			if (poll(&poll_fd, 1, timeout_milliseconds) <= 0) return false;
+
+			alignas(inotify_event) char buffer[64 * 1024];
+
+			ssize_t length = read(fd, buffer, sizeof(buffer));
+			if (length <= 0) return false;
+
+			for (char * e = buffer; e < buffer + length;) {
+				const inotify_event * event = reinterpret_cast<const inotify_event *>(e);
+				e += sizeof(inotify_event) + event->len;
+
+				if (event->mask & IN_Q_OVERFLOW) {
+					changes.push_back(Change(Change::Type::rescan, boost::filesystem::path()));
+					continue;
+				}
+
+				auto directory = directories.find(event->wd);
+				if (directory == directories.end()) continue;
+
+				if (event->mask & IN_IGNORED) {
+					directories.erase(directory);
+					continue;
+				}
+
+				if (event->len == 0) continue;
+
+				boost::filesystem::path filename = directory->second / event->name;
+
+				if (event->mask & IN_ISDIR) {
+					if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+						WatchDirectory(filename, &changes);
+					} else if (event->mask & IN_MOVED_FROM) {
+						changes.push_back(Change(Change::Type::rescan, filename)); // Files of the directory are no longer in the tree
+					}
+				} else if (IsExtendedCppFile(filename)) {
+					if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+						changes.push_back(Change(Change::Type::removed, filename));
+					} else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+						changes.push_back(Change(Change::Type::modified, filename));
+					}
+				}
+			}
+
+			return changes.size() > initial_changes;
+		}
+	};
+#else
+	class FileWatcher::Implementation {
+	private:
+		static constexpr int POLLING_INTERVAL_MILLISECONDS = 250;
+
+		struct FileState {
+			std::time_t last_write_time;
+			uintmax_t size;
+
+			bool operator != (const FileState & other) const {
+				return last_write_time != other.last_write_time || size != other.size;
+			}
+		};
+
+		typedef std::unordered_map<std::string, FileState> Files;
+
+		boost::filesystem::path base_dir;
+		Files files;
+
+		Files Scan() const {
+			using namespace boost::filesystem;
+
+			Files result;
+
+			boost::system::error_code error;
+			for (recursive_directory_iterator entry(base_dir, error), end; !error && entry != end; entry.increment(error)) {
+				if (!IsExtendedCppFile(entry->path())) continue;
+
+				boost::system::error_code file_error;
+				FileState state { last_write_time(entry->path(), file_error), file_size(entry->path(), file_error) };
+				if (!file_error) result[entry->path().string()] = state;
+			}
+
+			return result;
+		}
+
+	public:
+		explicit Implementation(const boost::filesystem::path & base_dir) : base_dir(base_dir), files(Scan()) {}
+
+		bool WaitForChanges(std::vector<Change> & changes, int timeout_milliseconds) {
+			size_t initial_changes = changes.size();
+			auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_milliseconds);
+
+			for (;;) {
+				int wait = POLLING_INTERVAL_MILLISECONDS;
+
+				if (timeout_milliseconds >= 0) {
+					auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+					if (remaining < wait) wait = (remaining > 0) ? static_cast<int>(remaining) : 0;
+				}
+
+				std::this_thread::sleep_for(std::chrono::milliseconds(wait));
+
+				Files current = Scan();
+
+				for (const auto & f : current) {
+					auto previous = files.find(f.first);
+					if (previous == files.end() || previous->second != f.second) changes.push_back(Change(Change::Type::modified, f.first));
+				}
+
+				for (const auto & f : files) {
+					if (current.find(f.first) == current.end()) changes.push_back(Change(Change::Type::removed, f.first));
+				}
+
+				files.swap(current);
+
+				if (changes.size() > initial_changes) return true;
+				if (timeout_milliseconds >= 0 && std::chrono::steady_clock::now() >= deadline) return false;
+			}
+		}
+	};
+#endif
+
+	FileWatcher::FileWatcher(const boost::filesystem::path & base_dir) : implementation(new Implementation(base_dir)) {}
+
+	FileWatcher::~FileWatcher() {}
+
+	bool FileWatcher::WaitForChanges(std::vector<Change> & changes, int timeout_milliseconds) {
+		return implementation->WaitForChanges(changes, timeout_milliseconds);
+	}
+}
@@ -0,0 +1,72 @@
+/*
+	Noel Lopes is a Professor at the Polytechnic of Guarda, Portugal
+	and a Researcher at the CISUC - University of Coimbra, Portugal
+	Copyright (C) 2017 Noel de Jesus Mendonça Lopes
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+#ifndef CPPX_FILE_WATCHER_H
+#define CPPX_FILE_WATCHER_H
+
+#include <memory>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+namespace cppx {
+
+	/// Watches a directory (and its subdirectories) for changes to the 
+	/// extended C++ files (.cppx). On Linux, it subscribes to the file system 
+	/// change notifications (inotify). On other systems, the directory is 
+	/// periodically scanned for changes.
+	class FileWatcher {
+	public:
+		struct Change {
+			enum class Type {
+				modified, // The file was created or modified
+				removed,  // The file was removed
+				rescan    // Changes were lost. All the files must be checked
+			};
+
+			Type type;
+			boost::filesystem::path filename;
+
+			Change(Type type, const boost::filesystem::path & filename) : type(type), filename(filename) {}
+		};
+
+		class Implementation;
+
+	private:
+		std::unique_ptr<Implementation> implementation;
+
+	public:
+		/// Starts watching a directory.
+		/// \param base_dir Directory to watch (along with its subdirectories).
+		/// \throws boost::filesystem::filesystem_error if the directory can not be watched.
+		explicit FileWatcher(const boost::filesystem::path & base_dir);
+
+		FileWatcher(const FileWatcher &) = delete;
+		FileWatcher & operator = (const FileWatcher &) = delete;
+
+		~FileWatcher();
+
+		/// Waits for changes to the extended C++ files (.cppx).
+		/// \param changes Vector that will be appended with the changes.
+		/// \param timeout_milliseconds Maximum time to wait (negative to wait indefinitely).
+		/// \return true if any changes were appended, false if the timeout expired.
+		bool WaitForChanges(std::vector<Change> & changes, int timeout_milliseconds);
+	};
+}
+
+#endif // CPPX_FILE_WATCHER_H
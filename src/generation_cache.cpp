@@ -0,0 +1,145 @@
+/*
+	Noel Lopes is a Professor at the Polytechnic of Guarda, Portugal
+	and a Researcher at the CISUC - University of Coimbra, Portugal
+	Copyright (C) 2017 Noel de Jesus Mendonça Lopes
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+#include <fstream>
+#include <map>
+#include <sstream>
+
+#include "generation_cache.h"
+#include "hash.h"
+#include "output_file.h"
+
+namespace cppx {
+	namespace {
+		const char CACHE_HEADER[] = "cppxcache 1 " CPPX_VERSION_STRING;
+
+		bool ReadFile(const boost::filesystem::path & filename, std::string & contents) {
+			std::ifstream file(filename.string(), std::ifstream::binary);
+			if (!file) return false;
+
+			std::ostringstream buffer;
+			buffer << file.rdbuf();
+			contents = buffer.str();
+
+			return !file.bad();
+		}
+	}
+
+	FileSignature::FileSignature(const std::string & contents) : size(contents.size()), hash(Hash(contents)) {}
+
+	constexpr const char * GenerationCache::FILENAME;
+
+	GenerationCache::GenerationCache(const boost::filesystem::path & base_dir) : cache_filename(base_dir / FILENAME), start_time(std::time(nullptr)) {
+		std::ifstream file(cache_filename.string(), std::ifstream::binary);
+
+		std::string line;
+		if (!std::getline(file, line) || line != CACHE_HEADER) return;
+
+		while (std::getline(file, line)) {
+			std::istringstream fields(line);
+
+			Entry entry;
+			fields >> entry.size >> entry.last_write_time >> std::hex >> entry.hash >> std::dec >> entry.header.size >> std::hex >> entry.header.hash >> std::dec >> entry.cpp.size >> std::hex >> entry.cpp.hash;
+
+			std::string filename;
+			if (fields.get() != '\t' || !std::getline(fields, filename) || filename.empty()) continue;
+
+			entries[filename] = entry;
+		}
+	}
+
+	bool GenerationCache::OutputMatches(const boost::filesystem::path & filename, const FileSignature & signature, bool check_contents) {
+		boost::system::error_code error;
+		auto size = boost::filesystem::file_size(filename, error);
+
+		if (error || size != signature.size) return false;
+		if (!check_contents) return true;
+
+		std::string contents;
+		return ReadFile(filename, contents) && FileSignature(contents) == signature;
+	}
+
+	bool GenerationCache::IsUpToDate(const boost::filesystem::path & filename, uintmax_t size) {
+		using namespace boost::filesystem;
+
+		Entry entry;
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			auto e = entries.find(filename.string());
+			if (e == entries.end()) return false;
+
+			entry = e->second;
+		}
+
+		if (entry.size != size) return false;
+
+		boost::system::error_code error;
+		std::time_t last_write_time = boost::filesystem::last_write_time(filename, error);
+		if (error) return false;
+
+		path header_filename = path(filename).replace_extension("h");
+		path cpp_filename = path(filename).replace_extension("cpp");
+
+		if (entry.last_write_time != 0 && entry.last_write_time == last_write_time) {
+			return OutputMatches(header_filename, entry.header, false) && OutputMatches(cpp_filename, entry.cpp, false);
+		}
+
+		// The file was touched (or its last write time could not be trusted): compare the contents
+		std::string contents;
+		if (!ReadFile(filename, contents) || Hash(contents) != entry.hash) return false;
+		if (!OutputMatches(header_filename, entry.header, true) || !OutputMatches(cpp_filename, entry.cpp, true)) return false;
+
+		entry.last_write_time = last_write_time;
+		Update(filename, entry);
+
+		return true;
+	}
+
+	void GenerationCache::Update(const boost::filesystem::path & filename, Entry entry) {
+		// A file modified in the same second the cache was created could be modified again without changing its last write time
+		if (entry.last_write_time + 1 >= start_time) entry.last_write_time = 0;
+
+		std::lock_guard<std::mutex> lock(mutex);
+		entries[filename.string()] = entry;
+	}
+
+	void GenerationCache::Remove(const boost::filesystem::path & filename) {
+		std::lock_guard<std::mutex> lock(mutex);
+		entries.erase(filename.string());
+	}
+
+	void GenerationCache::Save() {
+		std::lock_guard<std::mutex> lock(mutex);
+
+		std::map<std::string, const Entry *> sorted_entries;
+		for (const auto & e : entries) sorted_entries[e.first] = &e.second;
+
+		std::ostringstream contents;
+		contents << CACHE_HEADER << '\n';
+
+		for (const auto & e : sorted_entries) {
+			const Entry & entry = *e.second;
+
+			contents << entry.size << ' ' << entry.last_write_time << ' ' << std::hex << entry.hash << ' ' << std::dec << entry.header.size << ' ' << std::hex << entry.header.hash << ' ' << std::dec << entry.cpp.size << ' ' << std::hex << entry.cpp.hash << std::dec << '\t' << e.first << '\n';
+		}
+
+		WriteFileIfChanged(cache_filename, contents.str());
+	}
+}
@@ -0,0 +1,105 @@
+/*
+	Noel Lopes is a Professor at the Polytechnic of Guarda, Portugal
+	and a Researcher at the CISUC - University of Coimbra, Portugal
+	Copyright (C) 2017 Noel de Jesus Mendonça Lopes
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+#ifndef CPPX_GENERATION_CACHE_H
+#define CPPX_GENERATION_CACHE_H
+
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <boost/filesystem.hpp>
+
+namespace cppx {
+
+	/// Size and hash of a file.
+	struct FileSignature {
+		uintmax_t size;
+		uint64_t hash;
+
+		FileSignature() : size(0), hash(0) {}
+
+		FileSignature(const std::string & contents);
+
+		bool operator == (const FileSignature & other) const {
+			return size == other.size && hash == other.hash;
+		}
+	};
+
+	/// Persistent cache (manifest) of the extended C++ files (.cppx) that were
+	/// already processed, used to skip the files (and the generated .h and .cpp files)
+	/// that did not change since the last run.
+	/// The cache is stored in a .cppxcache file and is invalidated whenever the
+	/// cppxgen version changes. It can be safely used by several threads.
+	class GenerationCache {
+	public:
+		/// Information recorded for each extended C++ file (.cppx).
+		struct Entry {
+			uintmax_t size;
+			std::time_t last_write_time; // 0 when it can not be trusted
+			uint64_t hash;
+			FileSignature header;
+			FileSignature cpp;
+
+			Entry() : size(0), last_write_time(0), hash(0) {}
+		};
+
+	private:
+		boost::filesystem::path cache_filename;
+		std::unordered_map<std::string, Entry> entries;
+		std::mutex mutex;
+		std::time_t start_time;
+
+		static bool OutputMatches(const boost::filesystem::path & filename, const FileSignature & signature, bool check_contents);
+
+	public:
+		/// Name of the file where the cache is stored.
+		static constexpr const char * FILENAME = ".cppxcache";
+
+		/// Loads the cache stored in the \a base_dir directory (if any).
+		/// \param base_dir Base directory of the extended C++ files (.cppx).
+		explicit GenerationCache(const boost::filesystem::path & base_dir);
+
+		GenerationCache(const GenerationCache &) = delete;
+		GenerationCache & operator = (const GenerationCache &) = delete;
+
+		/// Returns whether the code generated from an extended C++ file (.cppx) is up to date.
+		/// A file whose size and last write time match the recorded ones is not opened.
+		/// Otherwise, its contents are hashed and compared to those recorded.
+		/// In both cases, the generated files must exist and match the recorded ones.
+		/// \param filename Extended C++ file (.cppx).
+		/// \param size Size of the file.
+		bool IsUpToDate(const boost::filesystem::path & filename, uintmax_t size);
+
+		/// Records the code generated from an extended C++ file (.cppx).
+		/// \param filename Extended C++ file (.cppx).
+		/// \param entry Information about the file and the generated files.
+		void Update(const boost::filesystem::path & filename, Entry entry);
+
+		/// Forgets an extended C++ file (.cppx), so that it will be processed on the next run.
+		void Remove(const boost::filesystem::path & filename);
+
+		/// Writes the cache to the disk.
+		/// \throws boost::filesystem::filesystem_error if the cache could not be written.
+		void Save();
+	};
+}
+
+#endif // CPPX_GENERATION_CACHE_H
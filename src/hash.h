@@ -0,0 +1,75 @@
+/*
+	Noel Lopes is a Professor at the Polytechnic of Guarda, Portugal
+	and a Researcher at the CISUC - University of Coimbra, Portugal
+	Copyright (C) 2017 Noel de Jesus Mendonça Lopes
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+#ifndef CPPX_HASH_H
+#define CPPX_HASH_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace cppx {
+
+	/// Computes a fast (non-cryptographic) 64 bit hash of a sequence of bytes (MurmurHash64A).
+	/// \param data Bytes to hash.
+	/// \param size Number of bytes.
+	/// \return Hash of the bytes.
+	inline uint64_t Hash(const char * data, size_t size) {
+		constexpr uint64_t SEED = 0xC0FFEE;
+		constexpr uint64_t M = 0xC6A4A7935BD1E995ULL;
+		constexpr int R = 47;
+
+		uint64_t h = SEED ^ (size * M);
+
+		const char * end = data + (size & ~static_cast<size_t>(7));
+
+		for (; data != end; data += 8) {
+			uint64_t k;
+			memcpy(&k, data, 8);
+
+			k *= M;
+			k ^= k >> R;
+			k *= M;
+
+			h ^= k;
+			h *= M;
+		}
+
+		size_t remaining = size & 7;
+
+		if (remaining > 0) {
+			for (size_t i = remaining; i-- > 0;) {
+				h ^= static_cast<uint64_t>(static_cast<unsigned char>(data[i])) << (8 * i);
+			}
+
+			h *= M;
+		}
+
+		h ^= h >> R;
+		h *= M;
+		h ^= h >> R;
+
+		return h;
+	}
+
+	inline uint64_t Hash(const std::string & s) {
+		return Hash(s.data(), s.size());
+	}
+}
+
+#endif // CPPX_HASH_H
@@ -0,0 +1,55 @@
+/*
+	Noel Lopes is a Professor at the Polytechnic of Guarda, Portugal
+	and a Researcher at the CISUC - University of Coimbra, Portugal
+	Copyright (C) 2017 Noel de Jesus Mendonça Lopes
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+#ifndef CPPX_JSON_H
+#define CPPX_JSON_H
+
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+namespace cppx {
+
+	/// Returns a string as a JSON string literal (quoted and escaped).
+	/// \param s String to convert.
+	inline std::string JsonString(const std::string & s) {
+		std::ostringstream result;
+		result << '"';
+
+		for (char c : s) {
+			switch (c) {
+				case '"': result << "\\\""; break;
+				case '\\': result << "\\\\"; break;
+				case '\n': result << "\\n"; break;
+				case '\t': result << "\\t"; break;
+				default:
+					if (static_cast<unsigned char>(c) < 0x20) {
+						result << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec << std::setfill(' ');
+					} else {
+						result << c;
+					}
+					break;
+			}
+		}
+
+		result << '"';
+		return result.str();
+	}
+}
+
+#endif // CPPX_JSON_H
@@ -0,0 +1,95 @@
+/*
+	Noel Lopes is a Professor at the Polytechnic of Guarda, Portugal
+	and a Researcher at the CISUC - University of Coimbra, Portugal
+	Copyright (C) 2017 Noel de Jesus Mendonça Lopes
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+#ifndef CPPX_MEMORY_BUDGET_H
+#define CPPX_MEMORY_BUDGET_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+
+namespace cppx {
+
+	/// Limits the memory used by the workers processing the files (e.g. when running 
+	/// in containers with tight memory limits). Workers reserve an estimate of the memory 
+	/// they need before processing a file (input, code blocks and pending output) and 
+	/// back off (waiting for other workers to release memory) when the budget is reached.
+	/// Can be safely used by several threads.
+	class MemoryBudget {
+	private:
+		std::mutex mutex;
+		std::condition_variable memory_released;
+
+		size_t limit;
+		size_t reserved;
+
+		bool Fits(size_t bytes) const {
+			// A reservation is always granted when nothing is reserved, so that files larger than the budget are still processed (one at a time)
+			return reserved == 0 || bytes <= limit - std::min(reserved, limit);
+		}
+
+	public:
+		/// Creates a budget.
+		/// \param limit Maximum number of bytes that can be reserved.
+		explicit MemoryBudget(size_t limit) : limit(limit), reserved(0) {}
+
+		MemoryBudget(const MemoryBudget &) = delete;
+		MemoryBudget & operator = (const MemoryBudget &) = delete;
+
+		size_t Limit() const {
+			return limit;
+		}
+
+		/// Reserves memory, provided the budget is not exceeded.
+		/// \param bytes Number of bytes to reserve.
+		/// \return true if the memory was reserved, false otherwise.
+		bool TryReserve(size_t bytes) {
+			std::lock_guard<std::mutex> lock(mutex);
+
+			if (!Fits(bytes)) return false;
+
+			reserved += bytes;
+			return true;
+		}
+
+		/// Reserves memory, waiting until it can be reserved without exceeding the budget.
+		/// To avoid waiting forever, the memory already reserved by the calling thread should be released first.
+		/// \param bytes Number of bytes to reserve.
+		void Reserve(size_t bytes) {
+			std::unique_lock<std::mutex> lock(mutex);
+
+			memory_released.wait(lock, [this, bytes] { return Fits(bytes); });
+			reserved += bytes;
+		}
+
+		/// Releases memory previously reserved.
+		/// \param bytes Number of bytes to release.
+		void Release(size_t bytes) {
+			if (bytes == 0) return;
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				reserved -= bytes;
+			}
+
+			memory_released.notify_all();
+		}
+	};
+}
+
+#endif // CPPX_MEMORY_BUDGET_H
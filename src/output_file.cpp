@@ -0,0 +1,190 @@
+/*
+	Noel Lopes is a Professor at the Polytechnic of Guarda, Portugal
+	and a Researcher at the CISUC - University of Coimbra, Portugal
+	Copyright (C) 2017 Noel de Jesus Mendonça Lopes
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+
+#include "output_file.h"
+
+#ifdef BOOST_POSIX_API
+	#include <fcntl.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+namespace cppx {
+	bool FileHasContents(const boost::filesystem::path & filename, const std::string & contents) {
+		boost::system::error_code error;
+		auto size = boost::filesystem::file_size(filename, error);
+
+		if (error || size != contents.size()) return false;
+
+		std::ifstream file(filename.string(), std::ifstream::binary);
+		if (!file) return false;
+
+		constexpr size_t BUFFER_SIZE = 64 * 1024;
+		char buffer[BUFFER_SIZE];
+
+		for (size_t position = 0; position < contents.size();) {
+			file.read(buffer, BUFFER_SIZE);
+
+			size_t read = static_cast<size_t>(file.gcount());
+			if (read == 0 || read > contents.size() - position) return false;
+			if (memcmp(buffer, contents.data() + position, read) != 0) return false;
+
+			position += read;
+		}
+
+		return true;
+	}
+
+	bool WriteFileIfChanged(const boost::filesystem::path & filename, const std::string & contents) {
+		using namespace boost::filesystem;
+
+		if (FileHasContents(filename, contents)) return false;
+
+		path temporary_filename = filename;
+		temporary_filename += "." + unique_path().string() + ".tmp";
+
+		{
+			std::ofstream file(temporary_filename.string(), std::ofstream::binary | std::ofstream::trunc);
+
+			if (file) file.write(contents.data(), contents.size());
+			if (file) file.close();
+
+			if (!file) {
+				boost::system::error_code error((errno != 0) ? errno : EIO, boost::system::generic_category());
+
+				boost::system::error_code ignore;
+				remove(temporary_filename, ignore);
+
+				throw filesystem_error("Could not write file", filename, error);
+			}
+		}
+
+		boost::system::error_code error;
+		rename(temporary_filename, filename, error);
+
+		if (error) {
+			boost::system::error_code ignore;
+			remove(temporary_filename, ignore);
+
+			throw filesystem_error("Could not replace file", filename, error);
+		}
+
+		return true;
+	}
+
+#ifdef BOOST_POSIX_API
+	namespace {
+		boost::system::error_code ErrorCode(int error) {
+			return boost::system::error_code((error != 0) ? error : EIO, boost::system::generic_category());
+		}
+
+		bool FileHasContents(int directory, const std::string & name, const std::string & contents) {
+			int fd = openat(directory, name.c_str(), O_RDONLY | O_CLOEXEC);
+			if (fd < 0) return false;
+
+			struct stat status;
+			bool same = (fstat(fd, &status) == 0 && static_cast<uintmax_t>(status.st_size) == contents.size());
+
+			constexpr size_t BUFFER_SIZE = 64 * 1024;
+			char buffer[BUFFER_SIZE];
+
+			for (size_t position = 0; same && position < contents.size();) {
+				ssize_t bytes = read(fd, buffer, std::min(BUFFER_SIZE, contents.size() - position));
+
+				if (bytes < 0 && errno == EINTR) continue;
+
+				same = (bytes > 0 && memcmp(buffer, contents.data() + position, static_cast<size_t>(bytes)) == 0);
+				if (same) position += static_cast<size_t>(bytes);
+			}
+
+			close(fd);
+
+			return same;
+		}
+
+		// Returns 0 if the file was written or the error found otherwise
+		int WriteFile(int directory, const std::string & name, const std::string & contents) {
+			int fd = openat(directory, name.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+			if (fd < 0) return errno;
+
+			for (size_t position = 0; position < contents.size();) {
+				ssize_t bytes = write(fd, contents.data() + position, contents.size() - position);
+
+				if (bytes < 0) {
+					if (errno == EINTR) continue;
+
+					int error = errno;
+					close(fd);
+					return error;
+				}
+
+				position += static_cast<size_t>(bytes);
+			}
+
+			return (close(fd) == 0) ? 0 : errno;
+		}
+	}
+
+	OutputDirectory::OutputDirectory(const boost::filesystem::path & directory) : directory(directory) {
+		fd = open(directory.empty() ? "." : directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	}
+
+	OutputDirectory::~OutputDirectory() {
+		if (fd >= 0) close(fd);
+	}
+
+	bool OutputDirectory::WriteFileIfChanged(const std::string & name, const std::string & contents) {
+		using namespace boost::filesystem;
+
+		if (fd < 0) return cppx::WriteFileIfChanged(directory / name, contents);
+
+		if (FileHasContents(fd, name, contents)) return false;
+
+		std::string temporary_name = name + "." + unique_path().string() + ".tmp";
+
+		int error = WriteFile(fd, temporary_name, contents);
+
+		if (error != 0) {
+			unlinkat(fd, temporary_name.c_str(), 0);
+			throw filesystem_error("Could not write file", directory / name, ErrorCode(error));
+		}
+
+		if (renameat(fd, temporary_name.c_str(), fd, name.c_str()) != 0) {
+			error = errno;
+			unlinkat(fd, temporary_name.c_str(), 0);
+
+			throw filesystem_error("Could not replace file", directory / name, ErrorCode(error));
+		}
+
+		return true;
+	}
+#else
+	OutputDirectory::OutputDirectory(const boost::filesystem::path & directory) : directory(directory), fd(-1) {}
+
+	OutputDirectory::~OutputDirectory() {}
+
+	bool OutputDirectory::WriteFileIfChanged(const std::string & name, const std::string & contents) {
+		return cppx::WriteFileIfChanged(directory / name, contents);
+	}
+#endif
+}
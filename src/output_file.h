@@ -0,0 +1,77 @@
+/*
+	Noel Lopes is a Professor at the Polytechnic of Guarda, Portugal
+	and a Researcher at the CISUC - University of Coimbra, Portugal
+	Copyright (C) 2017 Noel de Jesus Mendonça Lopes
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+#ifndef CPPX_OUTPUT_FILE_H
+#define CPPX_OUTPUT_FILE_H
+
+#include <string>
+
+#include <boost/filesystem.hpp>
+
+namespace cppx {
+
+	/// Returns whether a file exists and has exactly the given contents.
+	/// The size of the file is checked first, so that its contents are
+	/// only read when the sizes match.
+	/// \param filename File to check.
+	/// \param contents Expected contents.
+	bool FileHasContents(const boost::filesystem::path & filename, const std::string & contents);
+
+	/// Writes \a contents to a file, unless the file already has exactly
+	/// those contents (in which case the file, and its timestamp, are kept
+	/// untouched). The contents are written to a temporary file in the same
+	/// directory, which then atomically replaces the destination file.
+	/// \param filename File to write.
+	/// \param contents Contents of the file.
+	/// \return true if the file was written, false if it was already up to date.
+	/// \throws boost::filesystem::filesystem_error if the file could not be written.
+	bool WriteFileIfChanged(const boost::filesystem::path & filename, const std::string & contents);
+
+	/// Directory of several files written one after another (see WriteFileIfChanged), which is kept
+	/// open while they are written. On POSIX systems, the files are compared, created and replaced
+	/// relative to the open directory, so that its path is not looked up again for each operation.
+	/// Elsewhere (or if the directory can not be opened), the files are written by their full path.
+	class OutputDirectory {
+	private:
+		boost::filesystem::path directory;
+		int fd; // -1 if the directory is not open
+
+	public:
+		/// Opens a directory.
+		/// \param directory Directory of the files (if empty, the current directory).
+		explicit OutputDirectory(const boost::filesystem::path & directory);
+
+		OutputDirectory(const OutputDirectory &) = delete;
+		OutputDirectory & operator = (const OutputDirectory &) = delete;
+
+		~OutputDirectory();
+
+		const boost::filesystem::path & Path() const {
+			return directory;
+		}
+
+		/// Writes \a contents to a file of the directory, unless it already has exactly those contents (see WriteFileIfChanged).
+		/// \param name Name of the file (without any directory).
+		/// \param contents Contents of the file.
+		/// \return true if the file was written, false if it was already up to date.
+		/// \throws boost::filesystem::filesystem_error if the file could not be written.
+		bool WriteFileIfChanged(const std::string & name, const std::string & contents);
+	};
+}
+
+#endif // CPPX_OUTPUT_FILE_H
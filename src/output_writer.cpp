@@ -0,0 +1,197 @@
+/*
+	Noel Lopes is a Professor at the Polytechnic of Guarda, Portugal
+	and a Researcher at the CISUC - University of Coimbra, Portugal
+	Copyright (C) 2017 Noel de Jesus Mendonça Lopes
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+#include <algorithm>
+#include <memory>
+
+#include "output_writer.h"
+#include "statistics.h"
+
+namespace cppx {
+	constexpr size_t OutputWriter::DEFAULT_NUMBER_THREADS;
+	constexpr size_t OutputWriter::DEFAULT_MAX_PENDING_BYTES;
+	constexpr size_t OutputWriter::BATCH_SIZE;
+
+	OutputWriter::OutputWriter(size_t number_threads, size_t max_pending_bytes, MemoryBudget * budget) : 
+		files_being_written(0), pending_bytes(0), max_pending_bytes(max_pending_bytes), finishing(false), stopping(false), budget(budget) {
+		for (size_t t = 0; t < number_threads; ++t) {
+			threads.push_back(std::thread([this] { WriteFiles(); }));
+		}
+	}
+
+	OutputWriter::~OutputWriter() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+
+		files_queued.notify_all();
+
+		for (auto & thread : threads) thread.join();
+	}
+
+	void OutputWriter::Write(const std::string & filename, std::string & contents, const boost::filesystem::path * source) {
+		size_t size = contents.size();
+		bool queued = false;
+		bool batch_ready = false;
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			if (!threads.empty() && pending_bytes + size <= max_pending_bytes && (budget == nullptr || budget->TryReserve(size))) {
+				File file { filename, std::string(), source };
+
+				if (!buffers.empty()) {
+					file.contents.swap(buffers.back());
+					buffers.pop_back();
+				}
+
+				file.contents.swap(contents);
+				queue.push_back(std::move(file));
+
+				pending_bytes += size;
+				queued = true;
+				batch_ready = BatchReady();
+			}
+		}
+
+		if (queued) {
+			if (batch_ready) files_queued.notify_one();
+			return;
+		}
+
+		Statistics::Timer timer(Statistics::Phase::write);
+
+		try {
+			Written(contents, WriteFileIfChanged(filename, contents));
+		} catch (const boost::filesystem::filesystem_error & exception) {
+			Failed(source, exception);
+		}
+	}
+
+	std::vector<OutputWriter::Failure> OutputWriter::Finish() {
+		std::unique_lock<std::mutex> lock(mutex);
+
+		// The remaining files are written, even if they do not fill a batch
+		finishing = true;
+		files_queued.notify_all();
+
+		files_written.wait(lock, [this] { return queue.empty() && files_being_written == 0; });
+		finishing = false;
+
+		std::vector<Failure> result;
+		result.swap(failures);
+
+		return result;
+	}
+
+	void OutputWriter::WriteFiles() {
+		std::vector<File> batch;
+		batch.reserve(BATCH_SIZE);
+
+		for (;;) {
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+
+				files_queued.wait(lock, [this] { return BatchReady() || stopping || (finishing && !queue.empty()); });
+				if (queue.empty()) return;
+
+				while (!queue.empty() && batch.size() < BATCH_SIZE) {
+					batch.push_back(std::move(queue.front()));
+					queue.pop_front();
+				}
+
+				files_being_written += batch.size();
+			}
+
+			WriteBatch(batch);
+
+			size_t bytes = 0;
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+
+				for (auto & file : batch) {
+					bytes += file.contents.size();
+
+					// When there is a budget, the storage is released (it would not be accounted for)
+					if (budget == nullptr && buffers.size() < BATCH_SIZE) {
+						file.contents.clear();
+						buffers.push_back(std::move(file.contents));
+					}
+				}
+
+				pending_bytes -= bytes;
+				files_being_written -= batch.size();
+
+				// Other threads may have been left waiting for the files queued meanwhile
+				if (BatchReady()) files_queued.notify_one();
+			}
+
+			if (budget != nullptr) budget->Release(bytes);
+
+			batch.clear();
+			files_written.notify_all();
+		}
+	}
+
+	void OutputWriter::WriteBatch(std::vector<File> & batch) {
+		Statistics::Timer timer(Statistics::Phase::write);
+
+		struct FileInDirectory {
+			std::string directory;
+			std::string name;
+			const File * file;
+		};
+
+		std::vector<FileInDirectory> files;
+		files.reserve(batch.size());
+
+		for (const auto & file : batch) {
+			boost::filesystem::path filename(file.filename);
+			files.push_back(FileInDirectory { filename.parent_path().string(), filename.filename().string(), &file });
+		}
+
+		// The files of each directory are written one after another, relative to the (open) directory
+		std::stable_sort(files.begin(), files.end(), [] (const FileInDirectory & a, const FileInDirectory & b) {
+			return a.directory < b.directory;
+		});
+
+		std::unique_ptr<OutputDirectory> directory;
+
+		for (const auto & f : files) {
+			if (directory == nullptr || directory->Path() != f.directory) directory.reset(new OutputDirectory(f.directory));
+
+			try {
+				Written(f.file->contents, directory->WriteFileIfChanged(f.name, f.file->contents));
+			} catch (const boost::filesystem::filesystem_error & exception) {
+				Failed(f.file->source, exception);
+			}
+		}
+	}
+
+	void OutputWriter::Written(const std::string & contents, bool changed) {
+		Statistics::Add(Statistics::Counter::bytes_out, contents.size());
+		Statistics::Add(changed ? Statistics::Counter::outputs_written : Statistics::Counter::outputs_unchanged);
+	}
+
+	void OutputWriter::Failed(const boost::filesystem::path * source, const boost::filesystem::filesystem_error & exception) {
+		std::lock_guard<std::mutex> lock(mutex);
+		failures.push_back(Failure { source, exception.what() });
+	}
+}
@@ -0,0 +1,123 @@
+/*
+	Noel Lopes is a Professor at the Polytechnic of Guarda, Portugal
+	and a Researcher at the CISUC - University of Coimbra, Portugal
+	Copyright (C) 2017 Noel de Jesus Mendonça Lopes
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+#ifndef CPPX_OUTPUT_WRITER_H
+#define CPPX_OUTPUT_WRITER_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "memory_budget.h"
+#include "output_file.h"
+
+namespace cppx {
+
+	/// Writes the generated files asynchronously, so that the threads generating the code do not 
+	/// wait for the file system. Files are queued (see Write) and written in batches by a pool of 
+	/// I/O threads, which group the files of each batch by directory: each directory is opened 
+	/// (and looked up) once per batch (see OutputDirectory). Files are written as WriteFileIfChanged 
+	/// does (unchanged files are kept untouched and the others are atomically replaced).
+	/// Can be safely used by several threads.
+	class OutputWriter {
+	public:
+		/// Default number of I/O threads, regardless of the number of cores (the threads mostly wait for the file system).
+		static constexpr size_t DEFAULT_NUMBER_THREADS = 4;
+
+		/// Default maximum number of bytes queued to be written.
+		static constexpr size_t DEFAULT_MAX_PENDING_BYTES = 64 * 1024 * 1024;
+
+		/// Maximum number of files written by an I/O thread at once.
+		static constexpr size_t BATCH_SIZE = 64;
+
+		/// File that could not be written.
+		struct Failure {
+			const boost::filesystem::path * source; // see Write
+			std::string message;
+		};
+
+	private:
+		struct File {
+			std::string filename;
+			std::string contents;
+			const boost::filesystem::path * source;
+		};
+
+		std::mutex mutex;
+		std::condition_variable files_queued;
+		std::condition_variable files_written;
+
+		std::deque<File> queue;
+		size_t files_being_written;
+		size_t pending_bytes;
+		size_t max_pending_bytes;
+		bool finishing; // whether Finish is waiting for the queued files
+		bool stopping;
+
+		MemoryBudget * budget;
+
+		std::vector<std::string> buffers; // storage of the contents of the files already written, reused by the next files
+		std::vector<Failure> failures;
+
+		std::vector<std::thread> threads;
+
+		// Files are only written once they fill a batch (or take half of the queue), unless the writer is finishing
+		bool BatchReady() const {
+			return queue.size() >= BATCH_SIZE || pending_bytes >= max_pending_bytes / 2;
+		}
+
+		void WriteFiles();
+		void WriteBatch(std::vector<File> & batch);
+
+		void Written(const std::string & contents, bool changed);
+		void Failed(const boost::filesystem::path * source, const boost::filesystem::filesystem_error & exception);
+
+	public:
+		/// Creates a writer and its I/O threads.
+		/// \param number_threads Number of I/O threads (if 0, files are written synchronously by Write).
+		/// \param max_pending_bytes Maximum number of bytes queued (files that do not fit are written synchronously by Write).
+		/// \param budget If not null, memory budget from which the queued files are also reserved (see MemoryBudget).
+		explicit OutputWriter(size_t number_threads = DEFAULT_NUMBER_THREADS, size_t max_pending_bytes = DEFAULT_MAX_PENDING_BYTES, MemoryBudget * budget = nullptr);
+
+		OutputWriter(const OutputWriter &) = delete;
+		OutputWriter & operator = (const OutputWriter &) = delete;
+
+		/// Waits for the queued files to be written and stops the I/O threads.
+		~OutputWriter();
+
+		/// Queues a file to be written. Its contents are taken, leaving in \a contents (empty) storage 
+		/// of a file already written, so that the caller can reuse it without allocating memory. Files 
+		/// that do not fit in the queue (or in the memory budget) are written by the calling thread.
+		/// Errors are not reported by this method, but by Finish.
+		/// \param filename File to write.
+		/// \param contents Contents of the file.
+		/// \param source File whose processing generated this one (e.g. the .cppx file), reported if the file can not be written.
+		void Write(const std::string & filename, std::string & contents, const boost::filesystem::path * source);
+
+		/// Waits until all the files queued so far are written.
+		/// \return The files that could not be written since the last call.
+		std::vector<Failure> Finish();
+	};
+}
+
+#endif // CPPX_OUTPUT_WRITER_H
@@ -19,13 +19,23 @@
 #ifndef CPPX_PARSER_H
 #define CPPX_PARSER_H
 
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <iterator>
+#include <memory>
 #include <vector>
-#include <regex>
+#include <string>
+#include <stdexcept>
 
 #include <boost/filesystem.hpp>
-#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/utility/string_ref.hpp>
 
 #include "console.h"
+#include "scanner.h"
+#include "source_file.h"
+#include "statistics.h"
 
 namespace cppx {
 	class Parser {
@@ -34,16 +44,14 @@ namespace cppx {
 		private:
 			const char * begin;
 			const char * current;
-			size_t line;
 
 			void Advance(size_t length) {
-				for (size_t i = 0; i < length; ++i) MoveNext();
+				current += length;
 			}
 
 		public:
 			explicit Iterator(const char * code) {
 				begin = current = code;
-				line = 1;
 			}
 
 			Iterator(const Iterator &) = default;
@@ -62,8 +70,10 @@ namespace cppx {
 				return (*current) ? *(current + 1) : 0;
 			}
 
+			/// Returns the line of the current position. 
+			/// Lines are computed on demand (they are only needed to report errors).
 			size_t Line() const {
-				return line;
+				return 1 + std::count(begin, current, '\n');
 			}
 
 			const char * Begin() const {
@@ -79,19 +89,20 @@ namespace cppx {
 			}
 
 			void MoveBack(size_t lenght) {
-				while (lenght-- > 0) MovePrevious();
+				current -= std::min(lenght, Index());
 			}
 
 			void MoveNext() {
-				if (!*current) return;
+				if (*current) ++current;
+			}
 
-				if (*current++ == '\n') line++;
+			/// Moves to the given position (which must belong to the code).
+			void MoveTo(const char * position) {
+				current = position;
 			}
 
 			void MovePrevious() {
-				if (current == begin) return;
-
-				if (*current-- == '\n') line--;
+				if (current != begin) --current;
 			}
 
 			unsigned char Next() {
@@ -100,37 +111,26 @@ namespace cppx {
 				return *current;
 			}
 
-			bool Match(const char * regular_expression, std::cmatch & match_result) {
-				if (std::regex_search(current, match_result, std::regex(regular_expression), std::regex_constants::match_continuous)) {
-					Advance(match_result.length());
-					return true;
-				}
-
-				return false;
-			}
-
-			bool Match(const char * regular_expression) {
-				std::cmatch match_result;
+			/// Advances past the characters recognized by a Scanner function.
+			/// \param scan Scanner function.
+			/// \return true if \a scan matched any characters, false otherwise.
+			bool Match(size_t (*scan)(const char *)) {
+				size_t length = scan(current);
+				Advance(length);
 
-				return Match(regular_expression, match_result);
+				return length > 0;
 			}
 
 			bool AdvanceUntilCharIsFound(char c) {
-				for (; *current; MoveNext()) {
-					if (*current == c) return true;
-				}
+				const char possible_chars[] = { c, 0 };
 
-				return false;
+				return AdvanceUntilCharIsFound(possible_chars);
 			}
 
 			bool AdvanceUntilCharIsFound(const char * possible_chars) {
-				for (; *current; MoveNext()) {
-					for (const char * c = possible_chars; *c; ++c) {
-						if (*current == *c) return true;
-					}
-				}
+				current = Scanner::FindFirstOf(current, possible_chars);
 
-				return false;
+				return *current != 0;
 			}
 		};
 
@@ -151,9 +151,9 @@ namespace cppx {
 			Type type;
 			size_t braces;
 			size_t parenthesis;
-			std::string name;
+			boost::string_ref name; // view within the parsed code
 
-			Container(const std::string & name, Parser::Container::Type type, size_t braces = 0) :
+			Container(boost::string_ref name, Parser::Container::Type type, size_t braces = 0) :
 				type(type), braces(braces), parenthesis(0), name(name) {}
 
 			Container(Parser::Container::Type type, size_t braces = 0) :
@@ -194,7 +194,7 @@ namespace cppx {
 
 		struct CodeBlock {
 		public:
-			enum class Type {
+			enum class Type : unsigned char {
 				none,
 				empty,
 				comment,
@@ -233,72 +233,356 @@ namespace cppx {
 			std::string ToString() const {
 				return std::string(begin, Size());
 			}
+
+			/// Returns a (non-owning) view of the code block, within the parsed code.
+			boost::string_ref View() const {
+				return boost::string_ref(begin, Size());
+			}
 		};
 
-	private:
-		boost::iostreams::mapped_file code;
-		std::vector<CodeBlock> code_blocks;
-		std::vector<Container> containers;
-		Iterator iterator;
+		/// Code blocks of the parsed code, stored as a struct of arrays: the types (1 byte each) and the 
+		/// 32-bit offsets (relative to the beginning of the code) where each block begins and ends. 
+		/// Besides, an index of the significant blocks (those that are not empty nor comments) lets the 
+		/// parser look back at the last significant blocks in constant time. Code blocks are accessed by value.
+		class CodeBlockList {
+		public:
+			/// Value of the indexes that do not refer to any code block.
+			static constexpr size_t NONE = static_cast<size_t>(-1);
 
-		// Excludes non code blocks
-		class CodeBlockReverseIterator {
-		private:
-			typename std::vector<CodeBlock>::reverse_iterator current;
-			typename std::vector<CodeBlock>::reverse_iterator end;
-			size_t skipped;
+			/// Maximum memory (in bytes) used by each code block (including the index of the significant blocks).
+			static constexpr size_t BYTES_PER_CODE_BLOCK = sizeof(CodeBlock::Type) + 3 * sizeof(uint32_t);
 
-		public:
-			explicit CodeBlockReverseIterator(std::vector<CodeBlock> & code_blocks) {
-				skipped = 0;
-
-				end = code_blocks.rend();
-				for (current = code_blocks.rbegin(); current != end; ++current) {
-					switch (current->type) {
-						case CodeBlock::Type::none:
-						case CodeBlock::Type::empty:
-						case CodeBlock::Type::comment:
-							skipped++;
-							break;
+			/// Size (in bytes) of the largest code whose code blocks can be stored.
+			static constexpr size_t MAX_CODE_SIZE = UINT32_MAX;
 
-						default:
-							return;
-					}
+			/// Iterates over the code blocks (by value), in the order of the code.
+			class const_iterator {
+			private:
+				const CodeBlockList * list;
+				size_t index;
+
+			public:
+				typedef std::input_iterator_tag iterator_category;
+				typedef CodeBlock value_type;
+				typedef std::ptrdiff_t difference_type;
+				typedef const CodeBlock * pointer;
+				typedef CodeBlock reference;
+
+				const_iterator(const CodeBlockList * list, size_t index) : list(list), index(index) {}
+
+				CodeBlock operator * () const {
+					return (*list)[index];
+				}
+
+				const_iterator & operator ++ () {
+					++index;
+					return *this;
+				}
+
+				bool operator == (const const_iterator & other) const {
+					return index == other.index;
+				}
+
+				bool operator != (const const_iterator & other) const {
+					return index != other.index;
 				}
+			};
+
+			CodeBlockList() : code(nullptr) {}
+
+			size_t size() const {
+				return types.size();
 			}
 
-			size_t Skipped() const {
-				return skipped;
+			bool empty() const {
+				return types.empty();
 			}
 
-			auto Current() const -> decltype(current) {
-				return current;
+			CodeBlock operator [] (size_t block) const {
+				return CodeBlock(types[block], Begin(block), End(block));
 			}
 
-			auto End() const -> decltype(end) {
-				return end;
+			CodeBlock back() const {
+				return (*this)[size() - 1];
 			}
 
-			auto Next() -> decltype(current) {
-				while (++current != end) {
-					switch (current->type) {
-						case CodeBlock::Type::none:
-						case CodeBlock::Type::empty:
-						case CodeBlock::Type::comment:
-							skipped++;
-							break;
+			const_iterator begin() const {
+				return const_iterator(this, 0);
+			}
 
-						default:
-							return current;
+			const_iterator end() const {
+				return const_iterator(this, size());
+			}
+
+			CodeBlock::Type Type(size_t block) const {
+				return types[block];
+			}
+
+			/// Returns the first character of a code block.
+			const char * Begin(size_t block) const {
+				return code + begins[block];
+			}
+
+			/// Returns the last character of a code block.
+			const char * End(size_t block) const {
+				return code + ends[block] - 1;
+			}
+
+			boost::string_ref View(size_t block) const {
+				return boost::string_ref(code + begins[block], ends[block] - begins[block]);
+			}
+
+			/// Returns whether blocks of the given type are significant (not empty nor comments).
+			static bool IsSignificant(CodeBlock::Type type) {
+				return type != CodeBlock::Type::none && type != CodeBlock::Type::empty && type != CodeBlock::Type::comment;
+			}
+
+			/// Returns the number of significant code blocks (see IsSignificant).
+			size_t NumberSignificant() const {
+				return significant.size();
+			}
+
+			/// Returns the index of a significant code block.
+			/// \param s Position of the block among the significant blocks (less than NumberSignificant()).
+			size_t Significant(size_t s) const {
+				return significant[s];
+			}
+
+		private:
+			friend class Parser;
+
+			const char * code; // beginning of the code, to which the offsets refer
+
+			std::vector<CodeBlock::Type> types;
+			std::vector<uint32_t> begins; // offset of the first character of each block
+			std::vector<uint32_t> ends; // offset following the last character of each block
+			std::vector<uint32_t> significant; // indexes of the significant blocks, in ascending order
+
+			uint32_t OffsetOf(const char * position) const {
+				return static_cast<uint32_t>(position - code);
+			}
+
+			// Removes all the code blocks, which will refer to the given code
+			void Reset(const char * code) {
+				this->code = code;
+
+				types.clear();
+				begins.clear();
+				ends.clear();
+				significant.clear();
+			}
+
+			void Reserve(size_t blocks) {
+				types.reserve(blocks);
+				begins.reserve(blocks);
+				ends.reserve(blocks);
+				significant.reserve(blocks / 2 + 1); // about half of the blocks are white spaces
+			}
+
+			void PushBack(CodeBlock::Type type, const char * begin, const char * end) {
+				if (IsSignificant(type)) significant.push_back(static_cast<uint32_t>(size()));
+
+				types.push_back(type);
+				begins.push_back(OffsetOf(begin));
+				ends.push_back(OffsetOf(end) + 1);
+			}
+
+			void PopBack() {
+				if (!significant.empty() && significant.back() == size() - 1) significant.pop_back();
+
+				types.pop_back();
+				begins.pop_back();
+				ends.pop_back();
+			}
+
+			void SetEnd(size_t block, const char * end) {
+				ends[block] = OffsetOf(end) + 1;
+			}
+
+			void SetType(size_t block, CodeBlock::Type type) {
+				bool was_significant = IsSignificant(types[block]);
+				types[block] = type;
+
+				if (was_significant == IsSignificant(type)) return;
+
+				auto position = std::lower_bound(significant.begin(), significant.end(), static_cast<uint32_t>(block));
+
+				if (was_significant) {
+					significant.erase(position);
+				} else {
+					significant.insert(position, static_cast<uint32_t>(block));
+				}
+			}
+
+			// Keeps only the first blocks
+			void Truncate(size_t blocks) {
+				types.resize(blocks);
+				begins.resize(blocks);
+				ends.resize(blocks);
+
+				significant.erase(std::lower_bound(significant.begin(), significant.end(), static_cast<uint32_t>(blocks)), significant.end());
+			}
+
+			// Removes the first blocks
+			void EraseFront(size_t blocks) {
+				types.erase(types.begin(), types.begin() + blocks);
+				begins.erase(begins.begin(), begins.begin() + blocks);
+				ends.erase(ends.begin(), ends.begin() + blocks);
+
+				auto kept = std::lower_bound(significant.begin(), significant.end(), static_cast<uint32_t>(blocks));
+				significant.erase(significant.begin(), kept);
+
+				for (auto & s : significant) s -= static_cast<uint32_t>(blocks);
+			}
+
+			// Appends the blocks [first, last) of another list, whose offsets are displaced (when the code is edited)
+			void Append(const CodeBlockList & other, size_t first, size_t last, std::ptrdiff_t displacement) {
+				size_t appended_begin = size();
+
+				types.insert(types.end(), other.types.cbegin() + first, other.types.cbegin() + last);
+				begins.insert(begins.end(), other.begins.cbegin() + first, other.begins.cbegin() + last);
+				ends.insert(ends.end(), other.ends.cbegin() + first, other.ends.cbegin() + last);
+
+				if (displacement != 0) {
+					for (size_t b = appended_begin; b < size(); ++b) {
+						begins[b] = static_cast<uint32_t>(begins[b] + displacement);
+						ends[b] = static_cast<uint32_t>(ends[b] + displacement);
 					}
 				}
 
-				return current;
+				auto other_significant = std::lower_bound(other.significant.cbegin(), other.significant.cend(), static_cast<uint32_t>(first));
+
+				for (; other_significant != other.significant.cend() && *other_significant < last; ++other_significant) {
+					significant.push_back(static_cast<uint32_t>(*other_significant - first + appended_begin));
+				}
+			}
+
+			void swap(CodeBlockList & other) {
+				std::swap(code, other.code);
+
+				types.swap(other.types);
+				begins.swap(other.begins);
+				ends.swap(other.ends);
+				significant.swap(other.significant);
+			}
+		};
+
+		/// Storage shared by the parsers of several files (e.g. all the files processed by 
+		/// a thread). It keeps its capacity between files, so that (once it is large enough) 
+		/// parsing a file requires no memory allocations for the code blocks and containers.
+		/// A context can only be used by a single parser at a time (besides the previous parser of an incremental parser).
+		class Context {
+		private:
+			friend class Parser;
+
+			CodeBlockList code_blocks;
+			std::vector<Container> containers;
+			std::vector<char> buffer; // see SourceFile
+		};
+
+		/// Tag used to create an incremental parser, whose code blocks can be updated 
+		/// efficiently after the code is edited (see Parser(const Parser &, const Edit &)).
+		struct Incremental {};
+
+		/// Edit of the code of a parser: the characters in [offset, offset + removed) are replaced by the inserted ones.
+		struct Edit {
+			size_t offset;
+			size_t removed;
+			const char * inserted;
+			size_t inserted_size;
+		};
+
+	private:
+		// Code blocks reserved per byte of code (see Parser), in order to avoid growing code_blocks while parsing
+		static constexpr size_t ESTIMATED_BYTES_PER_CODE_BLOCK = 4;
+
+		SourceFile code;
+		CodeBlockList code_blocks;
+		std::vector<Container> containers;
+		Iterator iterator;
+		Context * context;
+
+		Container::Type next_container;
+		boost::string_ref last_identifier;
+		Scanner::Keyword last_identifier_keyword; // access modifiers (public, protected and private) are identifiers, as far as the parser is concerned
+		boost::string_ref container_name;
+
+		bool end_reached;
+		size_t released; // number of code blocks, at the beginning of code_blocks, already returned by NextCodeBlock
+
+		// Minimum distance (in bytes) between consecutive checkpoints (see Checkpoint)
+		static constexpr size_t CHECKPOINT_INTERVAL = 256;
+
+		// Portion of the code, given by its offset (see Checkpoint)
+		struct Span {
+			size_t offset;
+			size_t length;
+		};
+
+		struct CheckpointContainer {
+			Container::Type type;
+			size_t braces;
+			size_t parenthesis;
+			Span name;
+		};
+
+		struct CheckpointBlock {
+			CodeBlock::Type type;
+			size_t begin;
+			size_t end;
+		};
+
+		// State of an incremental parser right after a ';', '{' or '}' that is neither inside parentheses nor 
+		// inside a group other than a namespace, a class or a struct (see Parser(const Parser &, const Edit &)).
+		// The state only depends on the code before the checkpoint. Positions are kept as offsets, so that 
+		// checkpoints remain valid once the code is edited. The code blocks that could still change 
+		// (see NumberFinalCodeBlocks) are saved in checkpoint_blocks, as they were at the checkpoint.
+		struct Checkpoint {
+			size_t position; // offset of the code that follows the ';', '{' or '}'
+			size_t number_code_blocks;
+			size_t containers_begin; // containers are in checkpoint_containers[containers_begin, containers_end)
+			size_t containers_end;
+			size_t blocks_begin; // blocks that could still change are in checkpoint_blocks[blocks_begin, blocks_end)
+			size_t blocks_end;
+			Container::Type next_container;
+			Span last_identifier;
+			Scanner::Keyword last_identifier_keyword;
+			Span container_name;
+		};
+
+		// Checkpoints (only recorded by incremental parsers), sorted by position
+		std::vector<Checkpoint> checkpoints;
+		std::vector<CheckpointContainer> checkpoint_containers;
+		std::vector<CheckpointBlock> checkpoint_blocks;
+
+		// Iterates backwards over the significant code blocks (excluding the empty blocks and the comments), in constant time
+		class CodeBlockReverseIterator {
+		private:
+			const CodeBlockList & code_blocks;
+			size_t significant; // number of significant blocks up to the current one (0 once there are no more blocks)
+
+		public:
+			explicit CodeBlockReverseIterator(const CodeBlockList & code_blocks) : code_blocks(code_blocks), significant(code_blocks.NumberSignificant()) {}
+
+			// Number of (non significant) blocks skipped so far
+			size_t Skipped() const {
+				size_t following = code_blocks.size() - ((significant == 0) ? 0 : Current() + 1);
+
+				return following - (code_blocks.NumberSignificant() - significant);
+			}
+
+			// Index of the current block (CodeBlockList::NONE if there are no more blocks)
+			size_t Current() const {
+				return (significant == 0) ? CodeBlockList::NONE : code_blocks.Significant(significant - 1);
+			}
+
+			void Next() {
+				if (significant > 0) --significant;
 			}
 
 			CodeBlock::Type CurrentType() const {
-				if (current == end) return CodeBlock::Type::none;
-				return current->type;
+				if (significant == 0) return CodeBlock::Type::none;
+				return code_blocks.Type(Current());
 			}
 		};
 
@@ -309,7 +593,7 @@ namespace cppx {
 
 			switch (code_block.type) {
 				case CodeBlock::Type::begin_group:
-					if (code_blocks.back().type == CodeBlock::Type::empty) {
+					if (code_blocks.Type(code_blocks.size() - 1) == CodeBlock::Type::empty) {
 						blocks_to_merge = 1;
 					}
 
@@ -358,10 +642,11 @@ namespace cppx {
 			if (blocks_to_merge == 0) {
 				return false;
 			} else {
-				while (blocks_to_merge-- > 1) code_blocks.pop_back();
+				while (blocks_to_merge-- > 1) code_blocks.PopBack();
 
-				code_blocks.back().end = code_block.end;
-				code_blocks.back().type = code_block.type;
+				size_t last = code_blocks.size() - 1;
+				code_blocks.SetEnd(last, code_block.end);
+				code_blocks.SetType(last, code_block.type);
 
 				return true;
 			}
@@ -375,11 +660,13 @@ namespace cppx {
 				code_to_process = iterator.Begin();
 				line_last_block = 1;
 			} else {
+				size_t last = code_blocks.size() - 1;
+
 				auto MergeWithPrevious = [&] () -> bool {
 					if (type == CodeBlock::Type::previous_type) return true;
-					if (type == code_blocks.back().type) return true;
+					if (type == code_blocks.Type(last)) return true;
 
-					switch (code_blocks.back().type) {
+					switch (code_blocks.Type(last)) {
 						case CodeBlock::Type::arguments_or_parameters:
 							return containers.back().parenthesis > 0;
 
@@ -394,15 +681,15 @@ namespace cppx {
 				};
 
 				if (MergeWithPrevious()) {
-					code_blocks.back().end = iterator.Pointer() - 1;
+					code_blocks.SetEnd(last, iterator.Pointer() - 1);
 					return;
 				}
 
-				code_to_process = code_blocks.back().end + 1;
+				code_to_process = code_blocks.End(last) + 1;
 			}
 
 			if (begin > code_to_process) {
-				code_blocks.push_back(CodeBlock(CodeBlock::Type::other, code_to_process, begin - 1));
+				code_blocks.PushBack(CodeBlock::Type::other, code_to_process, begin - 1);
 			}
 
 			if (type == CodeBlock::Type::none) return;
@@ -410,23 +697,24 @@ namespace cppx {
 			CodeBlock code_block { type, begin, iterator.Pointer() - 1 };
 
 			if (!MergeCodeBlocks(code_block)) {
-				code_blocks.push_back(code_block);
+				code_blocks.PushBack(code_block.type, code_block.begin, code_block.end);
 			}
 		}
 
-		void ParseWhiteSpaces() {
-			while (isspace(iterator.Next()));
+		static void ParseWhiteSpaces(Iterator & iterator) {
+			iterator.MoveNext();
+			iterator.Match(Scanner::WhiteSpaces);
 		}
 
-		void ParseEscapeSequence() {
+		static void ParseEscapeSequence(Iterator & iterator) {
 			iterator.MoveNext();
 
-			if (!iterator.Match(R"(['"\?\\abfnrtv]|[0-7]{3}|x[0-9A-Fa-f]{2}|u[0-9A-Fa-f]{4}|U[0-9A-Fa-f]{8})")) {
+			if (!iterator.Match(Scanner::EscapeSequence)) {
 				throw Error("Invalid escape sequence", iterator);
 			}
 		}
 
-		void ParseCharLiteral() {
+		static void ParseCharLiteral(Iterator & iterator) {
 			auto c = iterator.Next();
 
 			switch (c) {
@@ -435,7 +723,7 @@ namespace cppx {
 					break;
 
 				case '\\':
-					ParseEscapeSequence();
+					ParseEscapeSequence(iterator);
 					break;
 
 				default:
@@ -450,7 +738,7 @@ namespace cppx {
 			iterator.MoveNext();
 		}
 
-		void ParseString() {
+		static void ParseString(Iterator & iterator) {
 			bool is_raw_string = (iterator.PreviousValue() == 'R');
 
 			Iterator iterator_start_string = iterator;
@@ -458,7 +746,7 @@ namespace cppx {
 			iterator.MoveNext();
 
 			if (is_raw_string) {
-				if (!iterator.Match(R"O(([^()\\\s]{0,16})\(.*?\)\1")O")) {
+				if (!iterator.Match(Scanner::RawString)) {
 					throw Error("Invalid raw string", iterator_start_string);
 				}
 			} else {
@@ -473,7 +761,7 @@ namespace cppx {
 							return;
 
 						case '\\':
-							ParseEscapeSequence();
+							ParseEscapeSequence(iterator);
 							break;
 
 						default:
@@ -484,11 +772,11 @@ namespace cppx {
 			}
 		}
 
-		void ParseDirective() {
+		static void ParseDirective(Iterator & iterator) {
 			iterator.MoveNext();
 
-			if (iterator.Match(R"(.*?/\*)")) { // Directive followed by C style comment in the same line
-				if (!iterator.Match(R"(.*?\*/.*)")) {
+			if (iterator.Match(Scanner::LineUntilCommentBegins)) { // Directive followed by C style comment in the same line
+				if (!iterator.Match(Scanner::LineWithCommentEnd)) {
 					iterator.MoveBack(2); // Comment does not end on this line, it has to be processed separately
 				}
 			} else { // Directive
@@ -497,10 +785,10 @@ namespace cppx {
 			}
 		}
 
-		bool ParseComments() {
+		static bool ParseComments(Iterator & iterator) {
 			switch (iterator.Peek()) {
 				case '*': // C comment
-					if (iterator.Match(R"(/\*[\s\S]*?\*/\s*\n*)")) {
+					if (iterator.Match(Scanner::CComment)) {
 						return true;
 					} else {
 						throw Error("C style comment (/*) does not end (*/)", iterator);
@@ -508,8 +796,8 @@ namespace cppx {
 					break;
 
 				case '/': // C++ comment
-					bool match = iterator.Match("//.*");
-					if (match) while (iterator.Match(R"(\s*//.*)"));
+					bool match = iterator.Match(Scanner::CppComment);
+					if (match) while (iterator.Match(Scanner::NextCppComment));
 
 					return match;
 			}
@@ -517,205 +805,995 @@ namespace cppx {
 			return false;
 		}
 
-	public:
+		static SourceFile LoadFile(const boost::filesystem::path & filename, Context * context) {
+			Statistics::Timer timer(Statistics::Phase::load);
 
-		/// Creates a parser for an .cppx file.
-		/// \param filename Filename path.
-		Parser(const boost::filesystem::path & filename) : code(filename, boost::iostreams::mapped_file::readonly), containers { Container(Container::Type::none) }, iterator(code.const_data()) {
-			Container::Type next_container = Container::Type::none;
-			std::string last_identifier;
-			std::string container_name;
+			SourceFile file(filename, (context != nullptr) ? std::move(context->buffer) : std::vector<char>());
+			Statistics::Add(Statistics::Counter::bytes_in, file.Size());
 
-			while (unsigned char c = iterator.Value()) {
-				CodeBlock::Type code_block_type = CodeBlock::Type::none;
+			return file;
+		}
 
-				const char * begin = iterator.Pointer();
+		static SourceFile LoadCode(const char * code, size_t size, Context * context) {
+			Statistics::Timer timer(Statistics::Phase::load);
 
-				switch (c) {
-					case '\'':
-						code_block_type = CodeBlock::Type::char_literal;
-						ParseCharLiteral();
-						break;
+			SourceFile file(code, size, (context != nullptr) ? std::move(context->buffer) : std::vector<char>());
+			Statistics::Add(Statistics::Counter::bytes_in, file.Size());
 
-					case '"':
-						code_block_type = CodeBlock::Type::string_literal;
-						ParseString();
-						break;
+			return file;
+		}
 
-					case '#':
-						code_block_type = CodeBlock::Type::directive;
-						ParseDirective();
-						break;
+		// Lexical element of the code (see Lex)
+		struct Token {
+			enum class Type : unsigned char {
+				end,
+				other, // characters that do not start any element
+				char_literal,
+				string_literal,
+				directive,
+				comment,
+				white_space,
+				identifier,
+				semicolon,
+				open_brace,
+				close_brace,
+				slash, // not starting a comment
+				open_parenthesis,
+				close_parenthesis,
+				comma,
+				colon,
+				scope, // ::
+				error // see LexedChunk
+			};
 
-					case ';':
-						code_block_type = CodeBlock::Type::statement_terminator;
-						iterator.MoveNext();
-						break;
+			const char * begin;
+			const char * end;
+			Type type;
+			Scanner::Keyword keyword;
+		};
 
-					case '{':
-						code_block_type = CodeBlock::Type::begin_group;
-						iterator.MoveNext();
+		// Lexes the next element of the code, advancing the iterator past it.
+		// Lexing only depends on the position where it starts (not on the state of 
+		// the parser), which allows large files to be lexed in parallel (see ParseInParallel).
+		static void Lex(Iterator & iterator, Token & token) {
+			typedef Scanner::CharacterKind Kind;
 
-						if (next_container == Parser::Container::Type::none || containers.back().type == Container::Type::initialization_list) {
-							containers.back().braces++;
-						} else {
-							containers.push_back(Container(container_name, next_container, 1));
-							next_container = Container::Type::none;
-							container_name.clear();
-						}
+			token.begin = iterator.Pointer();
+			token.keyword = Scanner::Keyword::none;
 
-						break;
+			switch (Scanner::Kind(iterator.Value())) {
+				case Kind::null:
+					token.type = Token::Type::end;
+					break;
 
-					case '}':
-						if (containers.back().braces-- == 0) {
-							throw Error("An extra '}' was found. Perhaps you forgot a '{'", iterator);
-						}
+				case Kind::single_quote:
+					token.type = Token::Type::char_literal;
+					ParseCharLiteral(iterator);
+					break;
 
-						if (containers.back().type == Container::Type::initialization_list) {
-							code_block_type = CodeBlock::Type::previous_type;
+				case Kind::double_quote:
+					token.type = Token::Type::string_literal;
+					ParseString(iterator);
+					break;
 
-							if (containers.back().braces == 0 && containers.back().parenthesis == 0) {
-								containers.pop_back();
-							}
-						} else {
-							code_block_type = CodeBlock::Type::end_group;
+				case Kind::hash:
+					token.type = Token::Type::directive;
+					ParseDirective(iterator);
+					break;
 
-							if (containers.back().braces == 0 && containers.size() > 1) {
-								containers.pop_back();
-							}
-						}
+				case Kind::semicolon:
+					token.type = Token::Type::semicolon;
+					iterator.MoveNext();
+					break;
 
+				case Kind::open_brace:
+					token.type = Token::Type::open_brace;
+					iterator.MoveNext();
+					break;
+
+				case Kind::close_brace:
+					token.type = Token::Type::close_brace;
+					iterator.MoveNext();
+					break;
+
+				case Kind::slash:
+					if (ParseComments(iterator)) {
+						token.type = Token::Type::comment;
+					} else {
+						token.type = Token::Type::slash;
 						iterator.MoveNext();
-						break;
+					}
+					break;
 
-					case '/':
-						if (ParseComments()) code_block_type = CodeBlock::Type::comment;
-						break;
+				case Kind::open_parenthesis:
+					token.type = Token::Type::open_parenthesis;
+					iterator.MoveNext();
+					break;
 
-					case '(':
-						code_block_type = CodeBlock::Type::arguments_or_parameters;
+				case Kind::close_parenthesis:
+					token.type = Token::Type::close_parenthesis;
+					iterator.MoveNext();
+					break;
 
-						switch (containers.back().type) {
-							case Container::Type::function:
-							case Container::Type::initialization_list:
-								break;
+				case Kind::comma:
+					token.type = Token::Type::comma;
+					iterator.MoveNext();
+					break;
 
-							default:
-								{
-									CodeBlockReverseIterator it(code_blocks);
-
-									auto c = it.Current();
-									if (c != it.End() && c->type == CodeBlock::Type::identifier) {
-										if (containers.back().name == c->ToString()) {
-											c->type = CodeBlock::Type::constructor_destructor;
-											next_container = Container::Type::constructor_destructor;
-										} else {
-											c->type = CodeBlock::Type::function_name;
-											next_container = Container::Type::function;
-										}
-										container_name = last_identifier;
-									}
-								}
+				case Kind::colon:
+					if (iterator.Next() == ':') {
+						token.type = Token::Type::scope;
+						iterator.MoveNext();
+					} else {
+						token.type = Token::Type::colon;
+					}
+					break;
 
-								break;
-						}
+				case Kind::identifier_start:
+					token.type = Token::Type::identifier;
+					iterator.Match(Scanner::Identifier);
+					token.keyword = Scanner::KeywordOf(token.begin, iterator.Pointer() - token.begin);
+					break;
 
-						containers.back().parenthesis++;
+				case Kind::white_space:
+					token.type = Token::Type::white_space;
+					ParseWhiteSpaces(iterator);
+					break;
 
-						iterator.MoveNext();
-						break;
+				default:
+					token.type = Token::Type::other;
+					do iterator.MoveNext(); while (Scanner::Kind(iterator.Value()) == Kind::other);
+					break;
+			}
 
-					case ')':
-						if (containers.back().parenthesis-- == 0) {
-							throw Error("An extra ')' was found. Perhaps you forgot a '('", iterator);
-						}
+			token.end = iterator.Pointer();
+		}
 
-						if (containers.back().type == Container::Type::initialization_list) {
-							code_block_type = CodeBlock::Type::previous_type;
+		// Processes a token (see Lex), updating the state of the parser and the code blocks.
+		// Returns false once the end of the code is reached.
+		bool Process(const Token & token) {
+			CodeBlock::Type code_block_type = CodeBlock::Type::none;
 
-							if (containers.back().braces == 0 && containers.back().parenthesis == 0) {
-								containers.pop_back();
-							}
-						} else {
-							code_block_type = CodeBlock::Type::arguments_or_parameters;
-						}
+			const char * begin = token.begin;
+			iterator.MoveTo(token.end);
 
-						iterator.MoveNext();
-						break;
+			switch (token.type) {
+				case Token::Type::end:
+					InsertCodeBlock(CodeBlock::Type::none, iterator.Pointer());
+					end_reached = true;
+					return false;
 
-					case ',':
-						if (containers.back().type != Container::Type::initialization_list) {
-							CodeBlockReverseIterator it(code_blocks);
+				case Token::Type::other:
+				case Token::Type::error:
+					return true;
 
-							if (it.CurrentType() == CodeBlock::Type::initialization_list) {
-								code_block_type = CodeBlock::Type::initialization_list;
-								containers.push_back(Container(Container::Type::initialization_list, 0));
-							}
-						}
+				case Token::Type::char_literal:
+					code_block_type = CodeBlock::Type::char_literal;
+					break;
 
-						iterator.MoveNext();
-						break;
+				case Token::Type::string_literal:
+					code_block_type = CodeBlock::Type::string_literal;
+					break;
 
-					case ':':
-						if (iterator.Next() == ':') {
-							code_block_type = CodeBlock::Type::identifier_scope;
-							iterator.MoveNext();
-						} else if (next_container == Container::Type::constructor_destructor) {
-							code_block_type = CodeBlock::Type::initialization_list;
-							containers.push_back(Container(Container::Type::initialization_list, 0));
-						} else if (last_identifier == "public" || last_identifier == "protected" || last_identifier == "private") {
-							code_block_type = CodeBlock::Type::access_modifier;
-						}
-						break;
+				case Token::Type::directive:
+					code_block_type = CodeBlock::Type::directive;
+					break;
 
-					default:
-						{
-							std::cmatch match_result;
-
-							if (iterator.Match(R"([_a-zA-Z]\w*)", match_result)) { // identifier
-								auto match_string = match_result.str();
-
-								if (match_string == "class") {
-									code_block_type = CodeBlock::Type::class_keyword;
-									next_container = Container::Type::class_container;
-									container_name.clear();
-								} else if (match_string == "enum") {
-									code_block_type = CodeBlock::Type::enumeration;
-									next_container = Container::Type::enumeration;
-									container_name.clear();
-								} else if (match_string == "namespace") {
-									code_block_type = CodeBlock::Type::namespace_keyword;
-									next_container = Container::Type::namespace_container;
-									container_name.clear();
-								} else if (match_string == "struct") {
-									code_block_type = CodeBlock::Type::struct_keyword;
-									next_container = Container::Type::struct_container;
-									container_name.clear();
-								} else {
-									code_block_type = CodeBlock::Type::identifier;
-									last_identifier = match_string;
-									if (container_name.empty()) container_name = last_identifier;
-								}
-							} else if (isspace(c)) {
-								code_block_type = CodeBlock::Type::empty;
-								ParseWhiteSpaces();
-							}
-						}
-						break;
-				}
+				case Token::Type::comment:
+					code_block_type = CodeBlock::Type::comment;
+					break;
 
-				if (code_block_type == CodeBlock::Type::none) {
-					iterator.MoveNext();
-				} else {
-					InsertCodeBlock(code_block_type, begin);
-				}
-			}
+				case Token::Type::white_space:
+					code_block_type = CodeBlock::Type::empty;
+					break;
 
-			InsertCodeBlock(CodeBlock::Type::none, iterator.Pointer());
-		}
+				case Token::Type::slash:
+					return true;
 
-		const std::vector<CodeBlock> & CodeBlocks() const {
-			return code_blocks;
+				case Token::Type::semicolon:
+					code_block_type = CodeBlock::Type::statement_terminator;
+					break;
+
+				case Token::Type::open_brace:
+					code_block_type = CodeBlock::Type::begin_group;
+
+					if (next_container == Parser::Container::Type::none || containers.back().type == Container::Type::initialization_list) {
+						containers.back().braces++;
+					} else {
+						containers.push_back(Container(container_name, next_container, 1));
+						next_container = Container::Type::none;
+						container_name.clear();
+					}
+
+					break;
+
+				case Token::Type::close_brace:
+					if (containers.back().braces-- == 0) {
+						iterator.MoveTo(begin);
+						throw Error("An extra '}' was found. Perhaps you forgot a '{'", iterator);
+					}
+
+					if (containers.back().type == Container::Type::initialization_list) {
+						code_block_type = CodeBlock::Type::previous_type;
+
+						if (containers.back().braces == 0 && containers.back().parenthesis == 0) {
+							containers.pop_back();
+						}
+					} else {
+						code_block_type = CodeBlock::Type::end_group;
+
+						if (containers.back().braces == 0 && containers.size() > 1) {
+							containers.pop_back();
+						}
+					}
+
+					break;
+
+				case Token::Type::open_parenthesis:
+					code_block_type = CodeBlock::Type::arguments_or_parameters;
+
+					switch (containers.back().type) {
+						case Container::Type::function:
+						case Container::Type::initialization_list:
+							break;
+
+						default:
+							{
+								CodeBlockReverseIterator it(code_blocks);
+
+								if (it.CurrentType() == CodeBlock::Type::identifier) {
+									size_t c = it.Current();
+
+									if (code_blocks.View(c) == containers.back().name) {
+										code_blocks.SetType(c, CodeBlock::Type::constructor_destructor);
+										next_container = Container::Type::constructor_destructor;
+									} else {
+										code_blocks.SetType(c, CodeBlock::Type::function_name);
+										next_container = Container::Type::function;
+									}
+									container_name = last_identifier;
+								}
+							}
+
+							break;
+					}
+
+					containers.back().parenthesis++;
+					break;
+
+				case Token::Type::close_parenthesis:
+					if (containers.back().parenthesis-- == 0) {
+						iterator.MoveTo(begin);
+						throw Error("An extra ')' was found. Perhaps you forgot a '('", iterator);
+					}
+
+					if (containers.back().type == Container::Type::initialization_list) {
+						code_block_type = CodeBlock::Type::previous_type;
+
+						if (containers.back().braces == 0 && containers.back().parenthesis == 0) {
+							containers.pop_back();
+						}
+					} else {
+						code_block_type = CodeBlock::Type::arguments_or_parameters;
+					}
+
+					break;
+
+				case Token::Type::comma:
+					if (containers.back().type != Container::Type::initialization_list) {
+						CodeBlockReverseIterator it(code_blocks);
+
+						if (it.CurrentType() == CodeBlock::Type::initialization_list) {
+							code_block_type = CodeBlock::Type::initialization_list;
+							containers.push_back(Container(Container::Type::initialization_list, 0));
+						}
+					}
+					break;
+
+				case Token::Type::colon:
+					if (next_container == Container::Type::constructor_destructor) {
+						code_block_type = CodeBlock::Type::initialization_list;
+						containers.push_back(Container(Container::Type::initialization_list, 0));
+					} else if (last_identifier_keyword != Scanner::Keyword::none) {
+						code_block_type = CodeBlock::Type::access_modifier;
+					}
+					break;
+
+				case Token::Type::scope:
+					code_block_type = CodeBlock::Type::identifier_scope;
+					break;
+
+				case Token::Type::identifier:
+					{
+						boost::string_ref match_string(begin, token.end - begin);
+
+						switch (token.keyword) {
+							case Scanner::Keyword::class_keyword:
+								code_block_type = CodeBlock::Type::class_keyword;
+								next_container = Container::Type::class_container;
+								container_name.clear();
+								break;
+
+							case Scanner::Keyword::enum_keyword:
+								code_block_type = CodeBlock::Type::enumeration;
+								next_container = Container::Type::enumeration;
+								container_name.clear();
+								break;
+
+							case Scanner::Keyword::namespace_keyword:
+								code_block_type = CodeBlock::Type::namespace_keyword;
+								next_container = Container::Type::namespace_container;
+								container_name.clear();
+								break;
+
+							case Scanner::Keyword::struct_keyword:
+								code_block_type = CodeBlock::Type::struct_keyword;
+								next_container = Container::Type::struct_container;
+								container_name.clear();
+								break;
+
+							default:
+								code_block_type = CodeBlock::Type::identifier;
+								last_identifier = match_string;
+								last_identifier_keyword = token.keyword;
+								if (container_name.empty()) container_name = last_identifier;
+								break;
+						}
+					}
+					break;
+			}
+
+			if (code_block_type == CodeBlock::Type::none) {
+				iterator.MoveNext(); // the character following a ',' or a ':' that does not start a code block is skipped
+			} else {
+				InsertCodeBlock(code_block_type, begin);
+			}
+
+			return true;
+		}
+
+		// Parses the next element of the code.
+		// Returns false once the end of the code is reached.
+		bool Parse() {
+			if (end_reached) return false;
+
+			Token token;
+			Lex(iterator, token);
+
+			return Process(token);
+		}
+
+		// Tokens of a chunk of code, lexed speculatively (see ParseInParallel).
+		struct LexedChunk {
+			std::vector<Token> tokens;
+			std::unique_ptr<Error> error; // error found while lexing (the last token has the type Token::Type::error)
+		};
+
+		// Lexes the code in [begin, end) (the last token may extend beyond end), assuming that a 
+		// token starts at begin. Lexing stops at the first error, which is only reported (by 
+		// ParseInParallel) if it turns out that the parser would have found it.
+		static LexedChunk LexChunk(const char * code, const char * begin, const char * end) {
+			LexedChunk chunk;
+			chunk.tokens.reserve((end - begin) / ESTIMATED_BYTES_PER_CODE_BLOCK + 1);
+
+			Iterator iterator(code);
+			iterator.MoveTo(begin);
+
+			Token token;
+
+			while (iterator.Pointer() < end) {
+				const char * token_begin = iterator.Pointer();
+
+				try {
+					Lex(iterator, token);
+				} catch (const Error & error) {
+					chunk.error.reset(new Error(error));
+					chunk.tokens.push_back(Token { token_begin, token_begin, Token::Type::error, Scanner::Keyword::none });
+					break;
+				}
+
+				chunk.tokens.push_back(token);
+				if (token.type == Token::Type::end) break;
+			}
+
+			return chunk;
+		}
+
+		// Returns the beginning of the chunks (besides the first one) in which the code is split for 
+		// lexing in parallel. Chunks begin at lines that are likely to begin with a token (lines 
+		// that do not begin with white spaces, comments or a '*', which could be inside a comment).
+		std::vector<const char *> ChunkBeginnings(size_t chunk_size) const {
+			std::vector<const char *> beginnings;
+
+			const char * end = code.Data() + code.Size();
+
+			for (const char * nominal = code.Data() + chunk_size; nominal < end; nominal += chunk_size) {
+				const char * c = (beginnings.empty() || beginnings.back() < nominal) ? nominal : beginnings.back() + 1;
+
+				for (; (c = static_cast<const char *>(memchr(c, '\n', end - c))) != nullptr; ++c) {
+					unsigned char next = static_cast<unsigned char>(c[1]);
+
+					if (next != 0 && !Scanner::IsWhiteSpace(next) && next != '/' && next != '*') break;
+				}
+
+				if (c == nullptr) break;
+				if (c + 1 < nominal + chunk_size) beginnings.push_back(c + 1);
+			}
+
+			return beginnings;
+		}
+
+		// Parses the whole code, lexing chunks of code in parallel (speculatively). Lexed tokens are 
+		// processed in order and only used when they begin exactly where the parser is (as the lexing 
+		// only depends on the position where it begins, they are the same tokens that would be lexed by the parser). 
+		// Otherwise, the parser lexes the code itself until it reaches the beginning of a lexed token.
+		// Thus, the code blocks produced are exactly the same produced by parsing the code sequentially.
+		void ParseInParallel(size_t number_threads, size_t chunk_size) {
+			std::vector<const char *> beginnings = ChunkBeginnings(chunk_size);
+
+			if (beginnings.empty()) {
+				while (Parse());
+				return;
+			}
+
+			const char * code_begin = code.Data();
+			beginnings.push_back(code_begin + code.Size());
+
+			std::deque<std::future<LexedChunk>> chunks;
+			size_t next_chunk = 0;
+
+			// Keeps number_threads - 1 chunks being lexed (ahead of the parser)
+			auto LexAhead = [&] {
+				while (chunks.size() + 1 < number_threads && next_chunk + 1 < beginnings.size()) {
+					const char * begin = beginnings[next_chunk];
+					const char * end = beginnings[next_chunk + 1];
+
+					chunks.push_back(std::async(std::launch::async, [code_begin, begin, end] { return LexChunk(code_begin, begin, end); }));
+					next_chunk++;
+				}
+			};
+
+			LexAhead();
+
+			// The first chunk is parsed sequentially, while the others are being lexed
+			while (iterator.Pointer() < beginnings.front() && Parse());
+
+			for (size_t c = 1; c < beginnings.size() && !end_reached; ++c) {
+				LexedChunk chunk = chunks.front().get();
+				chunks.pop_front();
+				LexAhead();
+
+				auto token = chunk.tokens.cbegin();
+
+				while (iterator.Pointer() < beginnings[c] && !end_reached) {
+					while (token != chunk.tokens.cend() && token->begin < iterator.Pointer()) ++token;
+
+					if (token != chunk.tokens.cend() && token->begin == iterator.Pointer()) {
+						if (token->type == Token::Type::error) throw *chunk.error;
+						Process(*token++);
+					} else {
+						Parse();
+					}
+				}
+			}
+
+			while (Parse());
+		}
+
+		// Returns the number of code blocks (at the beginning of code_blocks) that will no longer change.
+		// Parsing can only change the blocks after the second to last block that is not 
+		// empty or a comment (see MergeWithPrevious, MergeCodeBlocks and the '(' case in Parse).
+		size_t NumberFinalCodeBlocks() const {
+			if (end_reached) return code_blocks.size();
+
+			size_t significant_blocks = code_blocks.NumberSignificant();
+
+			return (significant_blocks < 2) ? 0 : code_blocks.Significant(significant_blocks - 2);
+		}
+
+		Parser(const boost::filesystem::path & filename, Context * context) : Parser(LoadFile(filename, context), context) {}
+
+		// When a context is given, its storage is taken (and given back by the destructor)
+		Parser(SourceFile && source, Context * context) :
+			code(std::move(source)), 
+			iterator(code.Data()),
+			context(context),
+			next_container(Container::Type::none),
+			last_identifier_keyword(Scanner::Keyword::none),
+			end_reached(false),
+			released(0) {
+			if (context != nullptr) {
+				code_blocks.swap(context->code_blocks);
+				containers.swap(context->containers);
+
+				containers.clear();
+			}
+
+			code_blocks.Reset(code.Data());
+			containers.push_back(Container(Container::Type::none));
+
+			if (code.Size() > CodeBlockList::MAX_CODE_SIZE) throw Error("The code is too large to be parsed (4 GB at most)", iterator);
+		}
+
+		struct ParallelParsingSettings {
+			size_t number_threads;
+			size_t minimum_file_size;
+			size_t chunk_size;
+		};
+
+		static ParallelParsingSettings & ParallelParsing() {
+			static ParallelParsingSettings settings = { 1, DEFAULT_PARALLEL_MINIMUM_FILE_SIZE, DEFAULT_PARALLEL_CHUNK_SIZE };
+
+			return settings;
+		}
+
+		void ParseAll() {
+			Statistics::Timer timer(Statistics::Phase::parse);
+
+			const ParallelParsingSettings & settings = ParallelParsing();
+
+			if (settings.number_threads > 1 && code.Size() >= settings.minimum_file_size) {
+				ParseInParallel(settings.number_threads, settings.chunk_size);
+			} else {
+				while (Parse());
+			}
+
+			Statistics::Add(Statistics::Counter::code_blocks, code_blocks.size());
+		}
+
+		static SourceFile LoadEditedCode(const Parser & previous, const Edit & edit, Context * context) {
+			if (edit.offset > previous.CodeSize() || edit.removed > previous.CodeSize() - edit.offset) {
+				throw std::out_of_range("The edit goes beyond the end of the code");
+			}
+
+			Statistics::Timer timer(Statistics::Phase::load);
+
+			SourceFile file(previous.Code(), previous.CodeSize(), edit.offset, edit.removed, edit.inserted, edit.inserted_size, (context != nullptr) ? std::move(context->buffer) : std::vector<char>());
+			Statistics::Add(Statistics::Counter::bytes_in, file.Size());
+
+			return file;
+		}
+
+		size_t Offset(const char * position) const {
+			return position - code.Data();
+		}
+
+		Span SpanOf(boost::string_ref view) const {
+			if (view.empty()) return Span { 0, 0 };
+
+			return Span { Offset(view.data()), view.size() };
+		}
+
+		boost::string_ref ViewOf(const Span & span) const {
+			if (span.length == 0) return boost::string_ref();
+
+			return boost::string_ref(code.Data() + span.offset, span.length);
+		}
+
+		// Offset, after the edit, of a position of the code that follows the edit
+		static size_t Displaced(size_t offset, const Edit & edit) {
+			return offset - edit.removed + edit.inserted_size;
+		}
+
+		// Converts a span of the code before the edit into a span of the edited code. 
+		// Returns false if the span overlaps the characters replaced by the edit.
+		static bool Rebase(Span & span, const Edit & edit) {
+			if (span.length == 0 || span.offset + span.length <= edit.offset) return true;
+			if (span.offset < edit.offset + edit.removed) return false;
+
+			span.offset = Displaced(span.offset, edit);
+			return true;
+		}
+
+		void RecordCheckpoint() {
+			size_t position = iterator.Index();
+
+			if (!checkpoints.empty() && position < checkpoints.back().position + CHECKPOINT_INTERVAL) return;
+			if (containers.back().braces != ((containers.size() == 1) ? 0 : 1)) return;
+
+			for (const auto & container : containers) {
+				if (container.parenthesis != 0) return;
+
+				switch (container.type) {
+					case Container::Type::none:
+					case Container::Type::namespace_container:
+					case Container::Type::class_container:
+					case Container::Type::struct_container:
+						break;
+
+					default:
+						return;
+				}
+			}
+
+			Checkpoint checkpoint;
+
+			checkpoint.position = position;
+			checkpoint.number_code_blocks = code_blocks.size();
+
+			checkpoint.containers_begin = checkpoint_containers.size();
+			for (const auto & container : containers) {
+				checkpoint_containers.push_back(CheckpointContainer { container.type, container.braces, container.parenthesis, SpanOf(container.name) });
+			}
+			checkpoint.containers_end = checkpoint_containers.size();
+
+			checkpoint.blocks_begin = checkpoint_blocks.size();
+			for (size_t b = NumberFinalCodeBlocks(); b < code_blocks.size(); ++b) {
+				checkpoint_blocks.push_back(CheckpointBlock { code_blocks[b].type, Offset(code_blocks[b].begin), Offset(code_blocks[b].end) });
+			}
+			checkpoint.blocks_end = checkpoint_blocks.size();
+
+			checkpoint.next_container = next_container;
+			checkpoint.last_identifier = SpanOf(last_identifier);
+			checkpoint.last_identifier_keyword = last_identifier_keyword;
+			checkpoint.container_name = SpanOf(container_name);
+
+			checkpoints.push_back(checkpoint);
+		}
+
+		// Restores the state of the previous parser at its last checkpoint before the edit (if any), keeping its 
+		// code blocks and checkpoints up to there. Returns the index of the next checkpoint of the previous parser.
+		size_t Resume(const Parser & previous, const Edit & edit) {
+			auto checkpoint = std::upper_bound(previous.checkpoints.cbegin(), previous.checkpoints.cend(), edit.offset, [] (size_t offset, const Checkpoint & c) {
+				return offset < c.position;
+			});
+
+			if (checkpoint == previous.checkpoints.cbegin()) return 0;
+			--checkpoint;
+
+			checkpoints.assign(previous.checkpoints.cbegin(), checkpoint + 1);
+			checkpoint_containers.assign(previous.checkpoint_containers.cbegin(), previous.checkpoint_containers.cbegin() + checkpoint->containers_end);
+			checkpoint_blocks.assign(previous.checkpoint_blocks.cbegin(), previous.checkpoint_blocks.cbegin() + checkpoint->blocks_end);
+
+			// The code before the checkpoint is not changed by the edit (and neither are the offsets of its blocks)
+			const char * code_begin = code.Data();
+
+			size_t final_blocks = checkpoint->number_code_blocks - (checkpoint->blocks_end - checkpoint->blocks_begin);
+
+			code_blocks.Truncate(0);
+			code_blocks.Append(previous.code_blocks, 0, final_blocks, 0);
+
+			for (size_t b = checkpoint->blocks_begin; b < checkpoint->blocks_end; ++b) {
+				const CheckpointBlock & block = checkpoint_blocks[b];
+				code_blocks.PushBack(block.type, code_begin + block.begin, code_begin + block.end);
+			}
+
+			containers.clear();
+			for (size_t c = checkpoint->containers_begin; c < checkpoint->containers_end; ++c) {
+				const CheckpointContainer & container = checkpoint_containers[c];
+
+				containers.push_back(Container(ViewOf(container.name), container.type, container.braces));
+				containers.back().parenthesis = container.parenthesis;
+			}
+
+			next_container = checkpoint->next_container;
+			last_identifier = ViewOf(checkpoint->last_identifier);
+			last_identifier_keyword = checkpoint->last_identifier_keyword;
+			container_name = ViewOf(checkpoint->container_name);
+
+			iterator.MoveTo(code_begin + checkpoint->position);
+
+			return checkpoint - previous.checkpoints.cbegin() + 1;
+		}
+
+		// Returns whether the state of the parser is the state of the previous parser at the given checkpoint, 
+		// displaced by the edit. Names only matter for their contents, while code blocks must be displaced.
+		bool MatchesCheckpoint(const Parser & previous, const Checkpoint & checkpoint, const Edit & edit) const {
+			if (next_container != checkpoint.next_container || last_identifier_keyword != checkpoint.last_identifier_keyword) return false;
+			if (last_identifier != previous.ViewOf(checkpoint.last_identifier) || container_name != previous.ViewOf(checkpoint.container_name)) return false;
+
+			if (containers.size() != checkpoint.containers_end - checkpoint.containers_begin) return false;
+
+			for (size_t c = 0; c < containers.size(); ++c) {
+				const CheckpointContainer & container = previous.checkpoint_containers[checkpoint.containers_begin + c];
+
+				if (containers[c].type != container.type || containers[c].braces != container.braces || containers[c].parenthesis != container.parenthesis) return false;
+				if (containers[c].name != previous.ViewOf(container.name)) return false;
+			}
+
+			size_t blocks = checkpoint.blocks_end - checkpoint.blocks_begin;
+			if (blocks == 0 || blocks > code_blocks.size()) return false;
+
+			// The blocks that could still change must follow the edit
+			if (previous.checkpoint_blocks[checkpoint.blocks_begin].begin < edit.offset + edit.removed) return false;
+
+			for (size_t b = 0; b < blocks; ++b) {
+				CodeBlock code_block = code_blocks[code_blocks.size() - blocks + b];
+				const CheckpointBlock & block = previous.checkpoint_blocks[checkpoint.blocks_begin + b];
+
+				if (code_block.type != block.type) return false;
+				if (Offset(code_block.begin) != Displaced(block.begin, edit) || Offset(code_block.end) != Displaced(block.end, edit)) return false;
+			}
+
+			return true;
+		}
+
+		// Once the parser reaches (after the edit) a checkpoint of the previous parser with the same state, 
+		// the remaining code is the same and so are the remaining code blocks, which are taken from the previous 
+		// parser (along with its remaining checkpoints). Returns whether the code blocks are complete.
+		bool Resynchronize(const Parser & previous, const Edit & edit, size_t & next_checkpoint) {
+			size_t position = iterator.Index();
+
+			// Besides the remaining code, lexing a string depends on the previous character (see ParseString)
+			if (position <= edit.offset + edit.inserted_size) return false;
+
+			size_t previous_position = position - edit.inserted_size + edit.removed;
+
+			const auto & previous_checkpoints = previous.checkpoints;
+			while (next_checkpoint < previous_checkpoints.size() && previous_checkpoints[next_checkpoint].position < previous_position) ++next_checkpoint;
+
+			if (next_checkpoint == previous_checkpoints.size() || previous_checkpoints[next_checkpoint].position != previous_position) return false;
+
+			const Checkpoint & checkpoint = previous_checkpoints[next_checkpoint];
+			if (!MatchesCheckpoint(previous, checkpoint, edit)) return false;
+
+			size_t blocks = checkpoint.blocks_end - checkpoint.blocks_begin;
+			size_t final_blocks = code_blocks.size() - blocks;
+			size_t previous_final_blocks = checkpoint.number_code_blocks - blocks;
+
+			// The remaining blocks follow the edit, so all of them are displaced by the same amount
+			code_blocks.Truncate(final_blocks);
+			code_blocks.Append(previous.code_blocks, previous_final_blocks, previous.code_blocks.size(), static_cast<std::ptrdiff_t>(edit.inserted_size) - static_cast<std::ptrdiff_t>(edit.removed));
+
+			checkpoints.reserve(checkpoints.size() + previous_checkpoints.size() - next_checkpoint);
+			checkpoint_containers.reserve(checkpoint_containers.size() + previous.checkpoint_containers.size() - previous_checkpoints[next_checkpoint].containers_begin);
+			checkpoint_blocks.reserve(checkpoint_blocks.size() + previous.checkpoint_blocks.size() - previous_checkpoints[next_checkpoint].blocks_begin);
+
+			// Checkpoints referring to the characters replaced by the edit are dropped
+			for (size_t c = next_checkpoint; c < previous_checkpoints.size(); ++c) {
+				Checkpoint rebased = previous_checkpoints[c];
+
+				if (previous.checkpoint_blocks[rebased.blocks_begin].begin < edit.offset + edit.removed) continue;
+				if (!Rebase(rebased.last_identifier, edit) || !Rebase(rebased.container_name, edit)) continue;
+
+				size_t containers_begin = checkpoint_containers.size();
+				bool valid = true;
+
+				for (size_t i = rebased.containers_begin; i < rebased.containers_end && valid; ++i) {
+					CheckpointContainer container = previous.checkpoint_containers[i];
+
+					valid = Rebase(container.name, edit);
+					checkpoint_containers.push_back(container);
+				}
+
+				if (!valid) {
+					checkpoint_containers.erase(checkpoint_containers.begin() + containers_begin, checkpoint_containers.end());
+					continue;
+				}
+
+				rebased.containers_begin = containers_begin;
+				rebased.containers_end = checkpoint_containers.size();
+
+				size_t blocks_begin = checkpoint_blocks.size();
+
+				for (size_t i = rebased.blocks_begin; i < rebased.blocks_end; ++i) {
+					const CheckpointBlock & block = previous.checkpoint_blocks[i];
+					checkpoint_blocks.push_back(CheckpointBlock { block.type, Displaced(block.begin, edit), Displaced(block.end, edit) });
+				}
+
+				rebased.blocks_begin = blocks_begin;
+				rebased.blocks_end = checkpoint_blocks.size();
+
+				rebased.position = Displaced(rebased.position, edit);
+				rebased.number_code_blocks = rebased.number_code_blocks - previous_final_blocks + final_blocks;
+
+				checkpoints.push_back(rebased);
+			}
+
+			iterator.MoveTo(code.Data() + code.Size());
+			end_reached = true;
+
+			return true;
+		}
+
+		// Parses the whole code, recording checkpoints. When a previous parser is given, parsing resumes from its last checkpoint 
+		// before the edit and stops as soon as its state matches the previous parser at a checkpoint after the edit.
+		void ParseIncrementally(const Parser * previous, const Edit * edit) {
+			Statistics::Timer timer(Statistics::Phase::parse);
+
+			size_t next_checkpoint = (previous != nullptr) ? Resume(*previous, *edit) : 0;
+
+			Token token;
+
+			while (!end_reached) {
+				Lex(iterator, token);
+				Process(token);
+
+				switch (token.type) {
+					case Token::Type::semicolon:
+					case Token::Type::open_brace:
+					case Token::Type::close_brace:
+						if (previous != nullptr && Resynchronize(*previous, *edit, next_checkpoint)) break;
+						RecordCheckpoint();
+						break;
+
+					default:
+						break;
+				}
+			}
+
+			Statistics::Add(Statistics::Counter::code_blocks, code_blocks.size());
+		}
+
+	public:
+		/// Default minimum size of the files parsed in parallel (see SetParallelParsing).
+		static constexpr size_t DEFAULT_PARALLEL_MINIMUM_FILE_SIZE = 4 * 1024 * 1024;
+
+		/// Default size of the chunks lexed in parallel (see SetParallelParsing).
+		static constexpr size_t DEFAULT_PARALLEL_CHUNK_SIZE = 1024 * 1024;
+
+		/// Sets up the parallel parsing of very large files (by default files are parsed sequentially).
+		/// Chunks of the file are lexed in parallel, while the parser processes them in order, 
+		/// producing exactly the same code blocks as the sequential parsing. 
+		/// Streaming parsers always parse the files sequentially. Should be called before creating any parser.
+		/// \param number_threads Number of threads used to parse each file (1 disables the parallel parsing).
+		/// \param minimum_file_size Minimum size of the files parsed in parallel.
+		/// \param chunk_size Size of the chunks lexed in parallel.
+		static void SetParallelParsing(size_t number_threads, size_t minimum_file_size = DEFAULT_PARALLEL_MINIMUM_FILE_SIZE, size_t chunk_size = DEFAULT_PARALLEL_CHUNK_SIZE) {
+			ParallelParsingSettings & settings = ParallelParsing();
+
+			settings.number_threads = (number_threads == 0) ? 1 : number_threads;
+			settings.minimum_file_size = minimum_file_size;
+			settings.chunk_size = (chunk_size == 0) ? 1 : chunk_size;
+		}
+
+		/// Returns an estimate of the memory (in bytes) needed to parse code of the given size: the code, the code 
+		/// blocks (with up to 50% more while their storage grows) and the tokens lexed in parallel (see SetParallelParsing).
+		static size_t MemoryNeeded(size_t code_size) {
+			size_t memory = code_size + (code_size / ESTIMATED_BYTES_PER_CODE_BLOCK + 1) * CodeBlockList::BYTES_PER_CODE_BLOCK * 3 / 2;
+
+			const ParallelParsingSettings & settings = ParallelParsing();
+
+			if (settings.number_threads > 1 && code_size >= settings.minimum_file_size) {
+				size_t lexed_ahead = std::min(code_size, settings.number_threads * settings.chunk_size);
+				memory += (lexed_ahead / ESTIMATED_BYTES_PER_CODE_BLOCK + 1) * sizeof(Token) * 3 / 2;
+			}
+
+			return memory;
+		}
+
+		/// Tag used to create a streaming parser (see NextCodeBlock).
+		struct Streaming {};
+
+		/// Creates a parser for an .cppx file, which immediately parses the whole file.
+		/// \param filename Filename path.
+		Parser(const boost::filesystem::path & filename) : Parser(filename, nullptr) {
+			ParseAll();
+		}
+
+		/// Creates a parser for an .cppx file, which immediately parses the whole file,
+		/// using (and reusing) the storage of the given context.
+		/// \param filename Filename path.
+		/// \param context Context that provides the storage for the code blocks (see CodeBlocks).
+		Parser(const boost::filesystem::path & filename, Context & context) : Parser(filename, &context) {
+			code_blocks.Reserve(code.Size() / ESTIMATED_BYTES_PER_CODE_BLOCK + 1);
+			ParseAll();
+		}
+
+		/// Creates a parser for extended C++ code that is already in memory (e.g. the contents 
+		/// of an editor buffer), which immediately parses the whole code. The code is copied.
+		/// \param code Code (it does not need to be null-terminated).
+		/// \param size Size of the code.
+		Parser(const char * code, size_t size) : Parser(LoadCode(code, size, nullptr), nullptr) {
+			ParseAll();
+		}
+
+		/// Creates a parser for extended C++ code that is already in memory, which immediately 
+		/// parses the whole code, using (and reusing) the storage of the given context.
+		/// \param code Code (it does not need to be null-terminated).
+		/// \param size Size of the code.
+		/// \param context Context that provides the storage for the code and for the code blocks (see CodeBlocks).
+		Parser(const char * code, size_t size, Context & context) : Parser(LoadCode(code, size, &context), &context) {
+			code_blocks.Reserve(size / ESTIMATED_BYTES_PER_CODE_BLOCK + 1);
+			ParseAll();
+		}
+
+		/// Creates an incremental parser for extended C++ code that is already in memory (e.g. the contents 
+		/// of an editor buffer), which immediately parses the whole code. The code is copied. Besides 
+		/// the code blocks, the parser keeps checkpoints of its state, so that the code blocks can be 
+		/// updated efficiently once the code is edited (see Parser(const Parser &, const Edit &)).
+		/// \param code Code (it does not need to be null-terminated).
+		/// \param size Size of the code.
+		Parser(const char * code, size_t size, Incremental) : Parser(LoadCode(code, size, nullptr), nullptr) {
+			code_blocks.Reserve(size / ESTIMATED_BYTES_PER_CODE_BLOCK + 1);
+			ParseIncrementally(nullptr, nullptr);
+		}
+
+		/// Creates an incremental parser for extended C++ code that is already in memory (see Parser(const char *, size_t, Incremental)), 
+		/// using (and reusing) the storage of the given context.
+		/// \param code Code (it does not need to be null-terminated).
+		/// \param size Size of the code.
+		/// \param context Context that provides the storage for the code and for the code blocks.
+		Parser(const char * code, size_t size, Context & context, Incremental) : Parser(LoadCode(code, size, &context), &context) {
+			code_blocks.Reserve(size / ESTIMATED_BYTES_PER_CODE_BLOCK + 1);
+			ParseIncrementally(nullptr, nullptr);
+		}
+
+		/// Creates an incremental parser for the code of a previous parser, after being edited. Only the code 
+		/// around the edit is parsed: the code blocks before the edit are kept and parsing resumes from the last 
+		/// checkpoint before the edit (a ';', '{' or '}' outside parentheses and outside groups other than namespaces, 
+		/// classes and structs). Parsing stops as soon as the state of the parser lines up with the state of the 
+		/// previous parser at one of its checkpoints after the edit, and the remaining code blocks of the previous 
+		/// parser are reused (displaced by the edit). The code blocks are exactly the same that would result from 
+		/// parsing the whole (edited) code. The previous parser is only used during the construction.
+		/// \param previous Parser of the code before the edit (if it is not incremental, the whole code is parsed).
+		/// \param edit Edit of the code of the previous parser.
+		/// \throws std::out_of_range if the edit goes beyond the end of the code.
+		/// \throws Parser::Error if the edited code contains errors.
+		Parser(const Parser & previous, const Edit & edit) : Parser(LoadEditedCode(previous, edit, nullptr), nullptr) {
+			code_blocks.Reserve(previous.code_blocks.size() + edit.inserted_size / ESTIMATED_BYTES_PER_CODE_BLOCK + 1);
+			ParseIncrementally(&previous, &edit);
+		}
+
+		/// Creates an incremental parser for the code of a previous parser, after being edited (see Parser(const Parser &, const Edit &)), 
+		/// using (and reusing) the storage of the given context. Most of the time is spent copying the code and the code blocks, 
+		/// so reusing their storage reduces the latency considerably. The previous parser can use the same context: as parsers 
+		/// give their storage back once they are destroyed, the storage of two parsers is reused while the code is being edited.
+		/// \param previous Parser of the code before the edit.
+		/// \param edit Edit of the code of the previous parser.
+		/// \param context Context that provides the storage for the code and for the code blocks.
+		Parser(const Parser & previous, const Edit & edit, Context & context) : Parser(LoadEditedCode(previous, edit, &context), &context) {
+			code_blocks.Reserve(previous.code_blocks.size() + edit.inserted_size / ESTIMATED_BYTES_PER_CODE_BLOCK + 1);
+			ParseIncrementally(&previous, &edit);
+		}
+
+		/// Creates a streaming parser for an .cppx file. The code is only parsed as 
+		/// the code blocks are requested (see NextCodeBlock), which keeps the memory 
+		/// used by the code blocks bounded, regardless of the size of the file.
+		/// \param filename Filename path.
+		Parser(const boost::filesystem::path & filename, Streaming) : Parser(filename, nullptr) {}
+
+		/// Creates a streaming parser for an .cppx file (see NextCodeBlock), using (and reusing) the storage of the given context.
+		/// \param filename Filename path.
+		/// \param context Context that provides the storage for the code blocks.
+		Parser(const boost::filesystem::path & filename, Context & context, Streaming) : Parser(filename, &context) {}
+
+		Parser(const Parser &) = delete;
+		Parser & operator = (const Parser &) = delete;
+
+		~Parser() {
+			if (context != nullptr) {
+				context->code_blocks.swap(code_blocks);
+				context->containers.swap(containers);
+				context->buffer = code.ReleaseBuffer();
+			}
+		}
+
+		/// Returns the next code block of a streaming parser (the code is parsed 
+		/// just enough to produce it). Only a small window of code blocks, those 
+		/// that can still change while parsing, is kept in memory.
+		/// \param code_block Next code block.
+		/// \return true if a code block was returned, false if there are no more code blocks.
+		/// \throws Parser::Error if the code contains errors.
+		bool NextCodeBlock(CodeBlock & code_block) {
+			if (released == NumberFinalCodeBlocks()) {
+				code_blocks.EraseFront(released);
+				released = 0;
+
+				while (NumberFinalCodeBlocks() == 0 && Parse());
+
+				if (code_blocks.empty()) return false;
+			}
+
+			code_block = code_blocks[released++];
+
+			return true;
+		}
+
+		/// Returns the code blocks of the file (for parsers that are not streaming).
+		/// The code blocks are consecutive (each one begins right after the end of the previous one).
+		const CodeBlockList & CodeBlocks() const {
+			return code_blocks;
+		}
+
+		/// Returns the code (contents of the .cppx file) being parsed.
+		const char * Code() const {
+			return code.Data();
+		}
+
+		/// Returns the size (in bytes) of the code being parsed.
+		size_t CodeSize() const {
+			return code.Size();
 		}
 	};
 }
@@ -0,0 +1,384 @@
+/*
+	Noel Lopes is a Professor at the Polytechnic of Guarda, Portugal
+	and a Researcher at the CISUC - University of Coimbra, Portugal
+	Copyright (C) 2017 Noel de Jesus Mendonça Lopes
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+#include <cstdint>
+#include <cstring>
+
+#include "scanner.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define CPPX_SIMD_SSE2
+	#include <emmintrin.h>
+
+	#if defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER)
+		#define CPPX_SIMD_AVX2
+		#include <immintrin.h>
+
+		#if defined(_MSC_VER) && !defined(__clang__)
+			#include <intrin.h>
+			#define CPPX_TARGET_AVX2
+		#else
+			#define CPPX_TARGET_AVX2 __attribute__((target("avx2")))
+		#endif
+	#endif
+#elif defined(__aarch64__) || defined(_M_ARM64) || (defined(__ARM_NEON) && defined(__arm__))
+	#define CPPX_SIMD_NEON
+	#include <arm_neon.h>
+#endif
+
+// The vectorized scanners only load aligned blocks. Since an aligned block never 
+// crosses a page boundary, they never touch memory beyond the page that contains 
+// the null terminator of the code being scanned.
+
+namespace cppx {
+	//-------------------------------------------------
+	// Character table
+	//-------------------------------------------------
+	namespace {
+		constexpr bool InRange(unsigned c, char first, char last) {
+			return c >= static_cast<unsigned char>(first) && c <= static_cast<unsigned char>(last);
+		}
+	}
+
+	constexpr unsigned char Scanner::ClassesOf(unsigned c) {
+		return static_cast<unsigned char>(
+			((c == ' ' || InRange(c, '\t', '\r')) ? WHITE_SPACE : 0) |
+			((c == '\n' || c == '\r') ? LINE_TERMINATOR : 0) |
+			((InRange(c, 'a', 'z') || InRange(c, 'A', 'Z') || c == '_') ? IDENTIFIER_START : 0) |
+			(InRange(c, '0', '9') ? DIGIT : 0) |
+			(InRange(c, '0', '7') ? OCTAL_DIGIT : 0) |
+			((InRange(c, '0', '9') || InRange(c, 'a', 'f') || InRange(c, 'A', 'F')) ? HEX_DIGIT : 0)
+		);
+	}
+
+	constexpr Scanner::CharacterKind Scanner::KindOf(unsigned c) {
+		return
+			(c == 0) ? CharacterKind::null :
+			(c == '\'') ? CharacterKind::single_quote :
+			(c == '"') ? CharacterKind::double_quote :
+			(c == '#') ? CharacterKind::hash :
+			(c == ';') ? CharacterKind::semicolon :
+			(c == '{') ? CharacterKind::open_brace :
+			(c == '}') ? CharacterKind::close_brace :
+			(c == '/') ? CharacterKind::slash :
+			(c == '(') ? CharacterKind::open_parenthesis :
+			(c == ')') ? CharacterKind::close_parenthesis :
+			(c == ',') ? CharacterKind::comma :
+			(c == ':') ? CharacterKind::colon :
+			(ClassesOf(c) & WHITE_SPACE) ? CharacterKind::white_space :
+			(ClassesOf(c) & IDENTIFIER_START) ? CharacterKind::identifier_start :
+			CharacterKind::other;
+	}
+
+	#define CPPX_CHARACTER(c) { ClassesOf(c), KindOf(c) }
+	#define CPPX_CHARACTERS_4(c) CPPX_CHARACTER(c), CPPX_CHARACTER(c + 1), CPPX_CHARACTER(c + 2), CPPX_CHARACTER(c + 3)
+	#define CPPX_CHARACTERS_16(c) CPPX_CHARACTERS_4(c), CPPX_CHARACTERS_4(c + 4), CPPX_CHARACTERS_4(c + 8), CPPX_CHARACTERS_4(c + 12)
+	#define CPPX_CHARACTERS_64(c) CPPX_CHARACTERS_16(c), CPPX_CHARACTERS_16(c + 16), CPPX_CHARACTERS_16(c + 32), CPPX_CHARACTERS_16(c + 48)
+
+	// Initialized with constant expressions (at compile time), thus usable even during static initialization
+	const Scanner::CharacterInfo Scanner::CHARACTERS[256] = {
+		CPPX_CHARACTERS_64(0u), CPPX_CHARACTERS_64(64u), CPPX_CHARACTERS_64(128u), CPPX_CHARACTERS_64(192u)
+	};
+
+	#undef CPPX_CHARACTERS_64
+	#undef CPPX_CHARACTERS_16
+	#undef CPPX_CHARACTERS_4
+	#undef CPPX_CHARACTER
+
+	//-------------------------------------------------
+	// Keyword table
+	//-------------------------------------------------
+	static_assert(Scanner::KeywordHash("private", 7) == 1, "The keyword table must be updated");
+	static_assert(Scanner::KeywordHash("enum", 4) == 2, "The keyword table must be updated");
+	static_assert(Scanner::KeywordHash("namespace", 9) == 7, "The keyword table must be updated");
+	static_assert(Scanner::KeywordHash("protected", 9) == 8, "The keyword table must be updated");
+	static_assert(Scanner::KeywordHash("class", 5) == 10, "The keyword table must be updated");
+	static_assert(Scanner::KeywordHash("public", 6) == 11, "The keyword table must be updated");
+	static_assert(Scanner::KeywordHash("struct", 6) == 15, "The keyword table must be updated");
+
+	const Scanner::KeywordInfo Scanner::KEYWORDS[Scanner::KEYWORD_TABLE_SIZE] = {
+		{ "", 0, Keyword::none },
+		{ "private", 7, Keyword::private_keyword },
+		{ "enum", 4, Keyword::enum_keyword },
+		{ "", 0, Keyword::none },
+		{ "", 0, Keyword::none },
+		{ "", 0, Keyword::none },
+		{ "", 0, Keyword::none },
+		{ "namespace", 9, Keyword::namespace_keyword },
+		{ "protected", 9, Keyword::protected_keyword },
+		{ "", 0, Keyword::none },
+		{ "class", 5, Keyword::class_keyword },
+		{ "public", 6, Keyword::public_keyword },
+		{ "", 0, Keyword::none },
+		{ "", 0, Keyword::none },
+		{ "", 0, Keyword::none },
+		{ "struct", 6, Keyword::struct_keyword }
+	};
+
+	namespace {
+		constexpr size_t MAX_DELIMITERS = 4;
+
+
+		inline unsigned FirstBit(uint32_t mask) {
+			#if defined(_MSC_VER) && !defined(__clang__)
+				unsigned long index;
+				_BitScanForward(&index, mask);
+				return static_cast<unsigned>(index);
+			#else
+				return static_cast<unsigned>(__builtin_ctz(mask));
+			#endif
+		}
+
+		inline unsigned FirstBit(uint64_t mask) {
+			#if defined(_MSC_VER) && !defined(__clang__)
+				unsigned long index;
+				_BitScanForward64(&index, mask);
+				return static_cast<unsigned>(index);
+			#else
+				return static_cast<unsigned>(__builtin_ctzll(mask));
+			#endif
+		}
+
+		//-------------------------------------------------
+		// Scalar (fallback) implementation
+		//-------------------------------------------------
+		const char * FindFirstOfScalar(const char * code, const char * delimiters, size_t number_delimiters) {
+			for (;; ++code) {
+				char c = *code;
+				if (!c) return code;
+
+				for (size_t d = 0; d < number_delimiters; ++d) {
+					if (c == delimiters[d]) return code;
+				}
+			}
+		}
+
+		#if !defined(CPPX_SIMD_SSE2) && !defined(CPPX_SIMD_NEON)
+		const char * SkipWhiteSpacesScalar(const char * code) {
+			while (Scanner::IsWhiteSpace(*code)) ++code;
+			return code;
+		}
+		#endif
+
+		//-------------------------------------------------
+		// SSE2 implementation
+		//-------------------------------------------------
+		#ifdef CPPX_SIMD_SSE2
+		const char * FindFirstOfSse2(const char * code, const char * delimiters, size_t number_delimiters) {
+			__m128i d[MAX_DELIMITERS];
+			for (size_t i = 0; i < number_delimiters; ++i) d[i] = _mm_set1_epi8(delimiters[i]);
+
+			const __m128i zero = _mm_setzero_si128();
+
+			auto Matches = [&] (const char * block) -> uint32_t {
+				__m128i b = _mm_load_si128(reinterpret_cast<const __m128i *>(block));
+				__m128i m = _mm_cmpeq_epi8(b, zero);
+				for (size_t i = 0; i < number_delimiters; ++i) m = _mm_or_si128(m, _mm_cmpeq_epi8(b, d[i]));
+
+				return static_cast<uint32_t>(_mm_movemask_epi8(m));
+			};
+
+			size_t misalignment = reinterpret_cast<uintptr_t>(code) & 15;
+			const char * block = code - misalignment;
+
+			uint32_t mask = Matches(block) & (0xFFFFu << misalignment);
+			while (mask == 0) mask = Matches(block += 16);
+
+			return block + FirstBit(mask);
+		}
+
+		const char * SkipWhiteSpacesSse2(const char * code) {
+			const __m128i space = _mm_set1_epi8(' ');
+			const __m128i tab = _mm_set1_epi8('\t');
+			const __m128i range = _mm_set1_epi8('\r' - '\t');
+
+			auto NonWhiteSpaces = [&] (const char * block) -> uint32_t {
+				__m128i b = _mm_load_si128(reinterpret_cast<const __m128i *>(block));
+				__m128i offset = _mm_sub_epi8(b, tab);
+				__m128i control = _mm_cmpeq_epi8(_mm_min_epu8(offset, range), offset); // '\t' <= b <= '\r'
+				__m128i white_space = _mm_or_si128(control, _mm_cmpeq_epi8(b, space));
+
+				return ~static_cast<uint32_t>(_mm_movemask_epi8(white_space)) & 0xFFFFu;
+			};
+
+			size_t misalignment = reinterpret_cast<uintptr_t>(code) & 15;
+			const char * block = code - misalignment;
+
+			uint32_t mask = NonWhiteSpaces(block) & (0xFFFFu << misalignment);
+			while (mask == 0) mask = NonWhiteSpaces(block += 16);
+
+			return block + FirstBit(mask);
+		}
+		#endif
+
+		//-------------------------------------------------
+		// AVX2 implementation
+		//-------------------------------------------------
+		#ifdef CPPX_SIMD_AVX2
+		CPPX_TARGET_AVX2 const char * FindFirstOfAvx2(const char * code, const char * delimiters, size_t number_delimiters) {
+			__m256i d[MAX_DELIMITERS];
+			for (size_t i = 0; i < number_delimiters; ++i) d[i] = _mm256_set1_epi8(delimiters[i]);
+
+			const __m256i zero = _mm256_setzero_si256();
+
+			size_t misalignment = reinterpret_cast<uintptr_t>(code) & 31;
+			const char * block = code - misalignment;
+
+			for (uint32_t ignore = ~(0xFFFFFFFFu << misalignment);; block += 32, ignore = 0) {
+				__m256i b = _mm256_load_si256(reinterpret_cast<const __m256i *>(block));
+				__m256i m = _mm256_cmpeq_epi8(b, zero);
+				for (size_t i = 0; i < number_delimiters; ++i) m = _mm256_or_si256(m, _mm256_cmpeq_epi8(b, d[i]));
+
+				uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(m)) & ~ignore;
+				if (mask != 0) return block + FirstBit(mask);
+			}
+		}
+
+		CPPX_TARGET_AVX2 const char * SkipWhiteSpacesAvx2(const char * code) {
+			const __m256i space = _mm256_set1_epi8(' ');
+			const __m256i tab = _mm256_set1_epi8('\t');
+			const __m256i range = _mm256_set1_epi8('\r' - '\t');
+
+			size_t misalignment = reinterpret_cast<uintptr_t>(code) & 31;
+			const char * block = code - misalignment;
+
+			for (uint32_t ignore = ~(0xFFFFFFFFu << misalignment);; block += 32, ignore = 0) {
+				__m256i b = _mm256_load_si256(reinterpret_cast<const __m256i *>(block));
+				__m256i offset = _mm256_sub_epi8(b, tab);
+				__m256i control = _mm256_cmpeq_epi8(_mm256_min_epu8(offset, range), offset); // '\t' <= b <= '\r'
+				__m256i white_space = _mm256_or_si256(control, _mm256_cmpeq_epi8(b, space));
+
+				uint32_t mask = ~static_cast<uint32_t>(_mm256_movemask_epi8(white_space)) & ~ignore;
+				if (mask != 0) return block + FirstBit(mask);
+			}
+		}
+
+		bool SupportsAvx2() {
+			#if defined(_MSC_VER) && !defined(__clang__)
+				int info[4];
+				__cpuid(info, 0);
+				if (info[0] < 7) return false;
+
+				__cpuid(info, 1);
+				bool os_saves_ymm = (info[2] & (1 << 27)) && ((_xgetbv(0) & 6) == 6);
+
+				__cpuidex(info, 7, 0);
+				return os_saves_ymm && (info[1] & (1 << 5));
+			#else
+				__builtin_cpu_init();
+				return __builtin_cpu_supports("avx2");
+			#endif
+		}
+		#endif
+
+		//-------------------------------------------------
+		// NEON implementation
+		//-------------------------------------------------
+		#ifdef CPPX_SIMD_NEON
+		// Returns a mask with 4 bits per byte of the comparison result
+		inline uint64_t MaskNeon(uint8x16_t comparison) {
+			uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(comparison), 4);
+			return vget_lane_u64(vreinterpret_u64_u8(narrowed), 0);
+		}
+
+		const char * FindFirstOfNeon(const char * code, const char * delimiters, size_t number_delimiters) {
+			uint8x16_t d[MAX_DELIMITERS];
+			for (size_t i = 0; i < number_delimiters; ++i) d[i] = vdupq_n_u8(static_cast<uint8_t>(delimiters[i]));
+
+			size_t misalignment = reinterpret_cast<uintptr_t>(code) & 15;
+			const char * block = code - misalignment;
+
+			for (uint64_t ignore = (misalignment == 0) ? 0 : ~(~0ULL << (4 * misalignment));; block += 16, ignore = 0) {
+				uint8x16_t b = vld1q_u8(reinterpret_cast<const uint8_t *>(block));
+				uint8x16_t m = vceqq_u8(b, vdupq_n_u8(0));
+				for (size_t i = 0; i < number_delimiters; ++i) m = vorrq_u8(m, vceqq_u8(b, d[i]));
+
+				uint64_t mask = MaskNeon(m) & ~ignore;
+				if (mask != 0) return block + FirstBit(mask) / 4;
+			}
+		}
+
+		const char * SkipWhiteSpacesNeon(const char * code) {
+			size_t misalignment = reinterpret_cast<uintptr_t>(code) & 15;
+			const char * block = code - misalignment;
+
+			for (uint64_t ignore = (misalignment == 0) ? 0 : ~(~0ULL << (4 * misalignment));; block += 16, ignore = 0) {
+				uint8x16_t b = vld1q_u8(reinterpret_cast<const uint8_t *>(block));
+				uint8x16_t control = vcleq_u8(vsubq_u8(b, vdupq_n_u8('\t')), vdupq_n_u8('\r' - '\t')); // '\t' <= b <= '\r'
+				uint8x16_t white_space = vorrq_u8(control, vceqq_u8(b, vdupq_n_u8(' ')));
+
+				uint64_t mask = MaskNeon(vmvnq_u8(white_space)) & ~ignore;
+				if (mask != 0) return block + FirstBit(mask) / 4;
+			}
+		}
+		#endif
+
+		//-------------------------------------------------
+		// Selection of the implementation (at runtime)
+		//-------------------------------------------------
+		struct Implementation {
+			const char * name;
+			const char * (*find_first_of)(const char *, const char *, size_t);
+			const char * (*skip_white_spaces)(const char *);
+		};
+
+		Implementation SelectImplementation() {
+			#ifdef CPPX_SIMD_AVX2
+				if (SupportsAvx2()) return Implementation { "AVX2", FindFirstOfAvx2, SkipWhiteSpacesAvx2 };
+			#endif
+
+			#if defined(CPPX_SIMD_SSE2)
+				return Implementation { "SSE2", FindFirstOfSse2, SkipWhiteSpacesSse2 };
+			#elif defined(CPPX_SIMD_NEON)
+				return Implementation { "NEON", FindFirstOfNeon, SkipWhiteSpacesNeon };
+			#else
+				return Implementation { "scalar", FindFirstOfScalar, SkipWhiteSpacesScalar };
+			#endif
+		}
+
+		const Implementation & SelectedImplementation() {
+			static const Implementation implementation = SelectImplementation();
+			return implementation;
+		}
+	}
+
+	const char * Scanner::FindFirstOf(const char * code, const char * delimiters) {
+		size_t number_delimiters = strlen(delimiters);
+
+		if (number_delimiters > MAX_DELIMITERS) {
+			return FindFirstOfScalar(code, delimiters, number_delimiters);
+		}
+
+		return SelectedImplementation().find_first_of(code, delimiters, number_delimiters);
+	}
+
+	const char * Scanner::SkipWhiteSpaces(const char * code) {
+		return SelectedImplementation().skip_white_spaces(code);
+	}
+
+	const char * Scanner::FindCCommentEnd(const char * code) {
+		for (;; ++code) {
+			code = FindFirstOf(code, "*");
+			if (!*code || code[1] == '/') return code;
+		}
+	}
+
+	const char * Scanner::InstructionSet() {
+		return SelectedImplementation().name;
+	}
+}
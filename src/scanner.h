@@ -0,0 +1,315 @@
+/*
+	Noel Lopes is a Professor at the Polytechnic of Guarda, Portugal
+	and a Researcher at the CISUC - University of Coimbra, Portugal
+	Copyright (C) 2017 Noel de Jesus Mendonça Lopes
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+#ifndef CPPX_SCANNER_H
+#define CPPX_SCANNER_H
+
+#include <cstddef>
+#include <cstring>
+
+namespace cppx {
+
+	/// Hand-written scanning engine used by the Parser to recognize the
+	/// lexical elements of the extended C++ files (identifiers, escape
+	/// sequences, comments, raw strings and directives).
+	/// Each scanning function receives a pointer to a null-terminated
+	/// string and returns the number of characters matched at its
+	/// beginning (0 if there is no match).
+	/// Searches over long runs of characters (strings, comments and 
+	/// white spaces) are vectorized (SSE2/AVX2 or NEON), using the best 
+	/// instruction set available at runtime.
+	class Scanner {
+	public:
+		/// Kind of a character, used by the Parser to dispatch the parsing of the next element of the code.
+		enum class CharacterKind : unsigned char {
+			other,
+			null,
+			white_space,
+			identifier_start,
+			single_quote,
+			double_quote,
+			hash,
+			semicolon,
+			open_brace,
+			close_brace,
+			slash,
+			open_parenthesis,
+			close_parenthesis,
+			comma,
+			colon
+		};
+
+		/// Keywords relevant to the Parser (see KeywordOf).
+		enum class Keyword : unsigned char {
+			none,
+			class_keyword,
+			enum_keyword,
+			namespace_keyword,
+			struct_keyword,
+			public_keyword,
+			protected_keyword,
+			private_keyword
+		};
+
+	private:
+		// Character classes (bit flags)
+		enum : unsigned char {
+			WHITE_SPACE = 1,
+			LINE_TERMINATOR = 2,
+			IDENTIFIER_START = 4,
+			DIGIT = 8,
+			OCTAL_DIGIT = 16,
+			HEX_DIGIT = 32,
+			IDENTIFIER_CHAR = IDENTIFIER_START | DIGIT
+		};
+
+		struct CharacterInfo {
+			unsigned char classes;
+			CharacterKind kind;
+		};
+
+		// Information about each (unsigned) character, computed at compile time (see scanner.cpp)
+		static const CharacterInfo CHARACTERS[256];
+
+		static constexpr unsigned char ClassesOf(unsigned c);
+		static constexpr CharacterKind KindOf(unsigned c);
+
+		struct KeywordInfo {
+			const char * text;
+			size_t length;
+			Keyword keyword;
+		};
+
+		static constexpr size_t KEYWORD_TABLE_SIZE = 16;
+
+		// Keywords, indexed by their (perfect) hash (see scanner.cpp)
+		static const KeywordInfo KEYWORDS[KEYWORD_TABLE_SIZE];
+
+		static const CharacterInfo & Info(char c) {
+			return CHARACTERS[static_cast<unsigned char>(c)];
+		}
+
+	public:
+		/// Finds the first occurrence of any of the given delimiters (at most 4 are vectorized).
+		/// \param code Null-terminated string to search.
+		/// \param delimiters Characters to search for.
+		/// \return Pointer to the first delimiter found or to the null terminator if none is found.
+		static const char * FindFirstOf(const char * code, const char * delimiters);
+
+		/// Finds the first non white space character.
+		/// \return Pointer to the first non white space character (possibly the null terminator).
+		static const char * SkipWhiteSpaces(const char * code);
+
+		/// Finds the end of a C style comment.
+		/// \return Pointer to the first "*/" found or to the null terminator if none is found.
+		static const char * FindCCommentEnd(const char * code);
+
+		/// Returns the name of the instruction set used by the vectorized searches.
+		static const char * InstructionSet();
+
+		/// Returns the kind of \a c (a single table lookup).
+		static CharacterKind Kind(char c) {
+			return Info(c).kind;
+		}
+
+		/// Returns whether \a c is a white space character (' ', '\\t', '\\n', '\\v', '\\f' or '\\r'), regardless of the locale.
+		static bool IsWhiteSpace(char c) {
+			return (Info(c).classes & WHITE_SPACE) != 0;
+		}
+
+		/// Returns whether \a c terminates a line ('\\n' or '\\r').
+		static bool IsLineTerminator(char c) {
+			return (Info(c).classes & LINE_TERMINATOR) != 0;
+		}
+
+		static bool IsIdentifierStart(char c) {
+			return (Info(c).classes & IDENTIFIER_START) != 0;
+		}
+
+		static bool IsIdentifierChar(char c) {
+			return (Info(c).classes & IDENTIFIER_CHAR) != 0;
+		}
+
+		static bool IsDigit(char c) {
+			return (Info(c).classes & DIGIT) != 0;
+		}
+
+		static bool IsOctalDigit(char c) {
+			return (Info(c).classes & OCTAL_DIGIT) != 0;
+		}
+
+		static bool IsHexDigit(char c) {
+			return (Info(c).classes & HEX_DIGIT) != 0;
+		}
+
+		/// Perfect hash of the keywords (each one has a distinct hash), based on their length and on their first and last characters.
+		static constexpr size_t KeywordHash(const char * identifier, size_t length) {
+			return (static_cast<unsigned char>(identifier[0]) + static_cast<unsigned char>(identifier[length - 1]) + (length << 2)) % KEYWORD_TABLE_SIZE;
+		}
+
+		/// Returns the keyword corresponding to an identifier (Keyword::none if it is not a keyword). 
+		/// Uses a perfect hash, so that (at most) a single comparison is needed.
+		/// \param identifier Identifier (at least one character).
+		/// \param length Length of the identifier.
+		static Keyword KeywordOf(const char * identifier, size_t length) {
+			const KeywordInfo & info = KEYWORDS[KeywordHash(identifier, length)];
+
+			if (info.length != length || memcmp(info.text, identifier, length) != 0) return Keyword::none;
+
+			return info.keyword;
+		}
+
+		/// Scans an identifier ([_a-zA-Z]\\w*).
+		static size_t Identifier(const char * code) {
+			if (!IsIdentifierStart(*code)) return 0;
+
+			const char * c = code + 1;
+			while (IsIdentifierChar(*c)) ++c;
+
+			return c - code;
+		}
+
+		/// Scans a sequence of white spaces (\\s*).
+		static size_t WhiteSpaces(const char * code) {
+			return SkipWhiteSpaces(code) - code;
+		}
+
+		/// Scans the characters up to the end of the line, excluding the line terminator (.*).
+		static size_t RestOfLine(const char * code) {
+			return FindFirstOf(code, "\n\r") - code;
+		}
+
+		/// Scans an escape sequence, excluding the initial backslash
+		/// (['"?\\abfnrtv], ooo, xhh, uhhhh or Uhhhhhhhh).
+		static size_t EscapeSequence(const char * code) {
+			switch (*code) {
+				case '\'':
+				case '"':
+				case '?':
+				case '\\':
+				case 'a':
+				case 'b':
+				case 'f':
+				case 'n':
+				case 'r':
+				case 't':
+				case 'v':
+					return 1;
+
+				case 'x':
+					return (IsHexDigit(code[1]) && IsHexDigit(code[2])) ? 3 : 0;
+
+				case 'u':
+					return HexDigits(code + 1, 4) ? 5 : 0;
+
+				case 'U':
+					return HexDigits(code + 1, 8) ? 9 : 0;
+
+				default:
+					return (IsOctalDigit(code[0]) && IsOctalDigit(code[1]) && IsOctalDigit(code[2])) ? 3 : 0;
+			}
+		}
+
+		/// Scans the remaining of a raw string, after its opening double quote
+		/// (delimiter, followed by '(', the string contents, ')', the delimiter and a closing double quote).
+		/// The delimiter can have at most 16 characters and the string can not span multiple lines.
+		static size_t RawString(const char * code) {
+			constexpr size_t MAX_DELIMITER_LENGTH = 16;
+
+			const char * c = code;
+			while (*c && *c != '(' && *c != ')' && *c != '\\' && !IsWhiteSpace(*c)) ++c;
+
+			size_t delimiter_length = c - code;
+			if (*c != '(' || delimiter_length > MAX_DELIMITER_LENGTH) return 0;
+
+			for (c = FindFirstOf(c + 1, ")\n\r"); *c == ')'; c = FindFirstOf(c + 1, ")\n\r")) {
+				if (EndsRawString(c + 1, code, delimiter_length)) {
+					return (c - code) + delimiter_length + 2;
+				}
+			}
+
+			return 0;
+		}
+
+		/// Scans a C style comment (/* ... */), including the white spaces that follow it.
+		static size_t CComment(const char * code) {
+			if (code[0] != '/' || code[1] != '*') return 0;
+
+			const char * c = FindCCommentEnd(code + 2);
+			if (!*c) return 0;
+
+			c += 2;
+			return (c - code) + WhiteSpaces(c);
+		}
+
+		/// Scans a C++ style comment (//...), up to the end of the line.
+		static size_t CppComment(const char * code) {
+			if (code[0] != '/' || code[1] != '/') return 0;
+
+			return 2 + RestOfLine(code + 2);
+		}
+
+		/// Scans a C++ style comment preceded by white spaces (\\s*//.*).
+		static size_t NextCppComment(const char * code) {
+			size_t white_spaces = WhiteSpaces(code);
+			size_t comment = CppComment(code + white_spaces);
+
+			return (comment == 0) ? 0 : white_spaces + comment;
+		}
+
+		/// Scans the characters of the current line up to (and including) the beginning of a C style comment (.*?/\\*).
+		static size_t LineUntilCommentBegins(const char * code) {
+			for (const char * c = FindFirstOf(code, "/\n\r"); *c == '/'; c = FindFirstOf(c + 1, "/\n\r")) {
+				if (c[1] == '*') return (c - code) + 2;
+			}
+
+			return 0;
+		}
+
+		/// Scans the current line, provided it contains the end of a C style comment (.*?\\*/.*).
+		static size_t LineWithCommentEnd(const char * code) {
+			for (const char * c = FindFirstOf(code, "*\n\r"); *c == '*'; c = FindFirstOf(c + 1, "*\n\r")) {
+				if (c[1] == '/') {
+					c += 2;
+					return (c - code) + RestOfLine(c);
+				}
+			}
+
+			return 0;
+		}
+
+	private:
+		static bool HexDigits(const char * code, size_t count) {
+			for (size_t i = 0; i < count; ++i) {
+				if (!IsHexDigit(code[i])) return false;
+			}
+
+			return true;
+		}
+
+		static bool EndsRawString(const char * code, const char * delimiter, size_t delimiter_length) {
+			for (size_t i = 0; i < delimiter_length; ++i) {
+				if (code[i] != delimiter[i]) return false;
+			}
+
+			return code[delimiter_length] == '"';
+		}
+	};
+}
+
+#endif // CPPX_SCANNER_H
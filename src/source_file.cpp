@@ -0,0 +1,165 @@
+/*
+	Noel Lopes is a Professor at the Polytechnic of Guarda, Portugal
+	and a Researcher at the CISUC - University of Coimbra, Portugal
+	Copyright (C) 2017 Noel de Jesus Mendonça Lopes
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+#include <cerrno>
+#include <fstream>
+
+#include "source_file.h"
+
+#ifdef BOOST_POSIX_API
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+namespace cppx {
+	constexpr size_t SourceFile::DEFAULT_MEMORY_MAP_THRESHOLD;
+
+	std::atomic<size_t> SourceFile::memory_map_threshold(SourceFile::DEFAULT_MEMORY_MAP_THRESHOLD);
+
+	namespace {
+		size_t PageSize() {
+		#ifdef BOOST_POSIX_API
+			static const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+			return page_size;
+		#else
+			return 4096;
+		#endif
+		}
+
+		// Whether the mapping of a file with the given size has room for (at least) a null terminator (the remaining of the last page is filled with zeros)
+		bool MappingIsNullTerminated(uintmax_t size) {
+			return size % PageSize() != 0;
+		}
+
+		bool ShouldMap(uintmax_t size) {
+			return size > 0 && size >= SourceFile::MemoryMapThreshold() && MappingIsNullTerminated(size);
+		}
+
+		[[noreturn]] void ThrowReadError(const boost::filesystem::path & filename, int error) {
+			throw boost::filesystem::filesystem_error("Could not read file", filename, boost::system::error_code((error != 0) ? error : EIO, boost::system::generic_category()));
+		}
+	}
+
+	SourceFile::SourceFile(const boost::filesystem::path & filename, std::vector<char> && buffer) : buffer(std::move(buffer)), size(0) {
+		if (!ReadFile(filename, true)) MapFile(filename);
+	}
+
+	SourceFile::SourceFile(const char * code, size_t size, std::vector<char> && buffer) : buffer(std::move(buffer)), size(size) {
+		this->buffer.assign(code, code + size);
+		this->buffer.push_back(0);
+	}
+
+	SourceFile::SourceFile(const char * code, size_t size, size_t offset, size_t removed, const char * inserted, size_t inserted_size, std::vector<char> && buffer) : 
+		buffer(std::move(buffer)), size(size - removed + inserted_size) {
+		this->buffer.reserve(this->size + 1);
+		this->buffer.assign(code, code + offset);
+		this->buffer.insert(this->buffer.end(), inserted, inserted + inserted_size);
+		this->buffer.insert(this->buffer.end(), code + offset + removed, code + size);
+		this->buffer.push_back(0);
+	}
+
+#ifdef BOOST_POSIX_API
+	bool SourceFile::ReadFile(const boost::filesystem::path & filename, bool map_large_files) {
+		int fd = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0) ThrowReadError(filename, errno);
+
+		struct stat status;
+		if (fstat(fd, &status) != 0) {
+			int error = errno;
+			close(fd);
+			ThrowReadError(filename, error);
+		}
+
+		size_t file_size = static_cast<size_t>(status.st_size);
+
+		if (map_large_files && ShouldMap(file_size)) {
+			close(fd);
+			return false;
+		}
+
+		buffer.resize(file_size + 1);
+
+		while (size < file_size) {
+			ssize_t bytes = read(fd, buffer.data() + size, file_size - size);
+
+			if (bytes < 0) {
+				if (errno == EINTR) continue;
+
+				int error = errno;
+				close(fd);
+				ThrowReadError(filename, error);
+			}
+
+			if (bytes == 0) break; // the file was truncated (meanwhile)
+			size += static_cast<size_t>(bytes);
+		}
+
+		close(fd);
+
+		buffer[size] = 0;
+
+		return true;
+	}
+#else
+	bool SourceFile::ReadFile(const boost::filesystem::path & filename, bool map_large_files) {
+		boost::system::error_code error;
+		uintmax_t file_size = boost::filesystem::file_size(filename, error);
+		if (error) throw boost::filesystem::filesystem_error("Could not read file", filename, error);
+
+		if (map_large_files && ShouldMap(file_size)) return false;
+
+		std::ifstream file(filename.string(), std::ifstream::binary);
+		if (!file) ThrowReadError(filename, errno);
+
+		buffer.resize(static_cast<size_t>(file_size) + 1);
+
+		file.read(buffer.data(), static_cast<std::streamsize>(file_size));
+		if (file.bad()) ThrowReadError(filename, errno);
+
+		size = static_cast<size_t>(file.gcount());
+		buffer[size] = 0;
+
+		return true;
+	}
+#endif
+
+	void SourceFile::MapFile(const boost::filesystem::path & filename) {
+		try {
+			mapped_file.open(filename, boost::iostreams::mapped_file::readonly);
+		} catch (const std::ios_base::failure &) {
+			ThrowReadError(filename, errno);
+		}
+
+		size = mapped_file.size();
+
+		if (!MappingIsNullTerminated(size)) {
+			// The file has changed (to a multiple of the page size) since its size was checked
+			mapped_file.close();
+			size = 0;
+
+			ReadFile(filename, false);
+			return;
+		}
+
+	#ifdef BOOST_POSIX_API
+		madvise(const_cast<char *>(mapped_file.const_data()), size, MADV_SEQUENTIAL);
+	#endif
+	}
+}
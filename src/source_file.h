@@ -0,0 +1,109 @@
+/*
+	Noel Lopes is a Professor at the Polytechnic of Guarda, Portugal
+	and a Researcher at the CISUC - University of Coimbra, Portugal
+	Copyright (C) 2017 Noel de Jesus Mendonça Lopes
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+#ifndef CPPX_SOURCE_FILE_H
+#define CPPX_SOURCE_FILE_H
+
+#include <atomic>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+
+namespace cppx {
+
+	/// Loads the contents of an extended C++ file (.cppx) into memory, always 
+	/// followed by a null terminator (which the Parser relies on).
+	/// Small files are read into a buffer, which can be reused across files 
+	/// (avoiding the cost of mapping and unmapping them), while larger files 
+	/// are memory mapped (and read sequentially).
+	class SourceFile {
+	public:
+		/// Default size (in bytes) from which files are memory mapped.
+		static constexpr size_t DEFAULT_MEMORY_MAP_THRESHOLD = 64 * 1024;
+
+	private:
+		static std::atomic<size_t> memory_map_threshold;
+
+		boost::iostreams::mapped_file mapped_file;
+		std::vector<char> buffer;
+		size_t size;
+
+		// Reads the file into the buffer, unless map_large_files is true and the file should be memory mapped (returning false)
+		bool ReadFile(const boost::filesystem::path & filename, bool map_large_files);
+		void MapFile(const boost::filesystem::path & filename);
+
+	public:
+		/// Sets the size (in bytes) from which files are memory mapped (0 to memory map all the files 
+		/// but the empty ones). Files whose size is a multiple of the page size are always read, since 
+		/// there would be no room for the null terminator in their mapping.
+		static void SetMemoryMapThreshold(size_t bytes) {
+			memory_map_threshold = bytes;
+		}
+
+		static size_t MemoryMapThreshold() {
+			return memory_map_threshold;
+		}
+
+		/// Loads a file.
+		/// \param filename File to load.
+		/// \param buffer Buffer where small files are read (its capacity is reused, see ReleaseBuffer).
+		/// \throws boost::filesystem::filesystem_error if the file could not be read.
+		SourceFile(const boost::filesystem::path & filename, std::vector<char> && buffer = std::vector<char>());
+
+		/// Copies code that is already in memory (e.g. the contents of an editor buffer).
+		/// \param code Code (it does not need to be null-terminated).
+		/// \param size Size of the code.
+		/// \param buffer Buffer where the code is copied (its capacity is reused, see ReleaseBuffer).
+		SourceFile(const char * code, size_t size, std::vector<char> && buffer = std::vector<char>());
+
+		/// Copies code that is already in memory, replacing some of its characters (e.g. after editing it).
+		/// \param code Code (it does not need to be null-terminated).
+		/// \param size Size of the code.
+		/// \param offset Position of the first character replaced.
+		/// \param removed Number of characters replaced (offset + removed can not exceed size).
+		/// \param inserted Characters that replace them.
+		/// \param inserted_size Number of characters inserted.
+		/// \param buffer Buffer where the code is copied (its capacity is reused, see ReleaseBuffer).
+		SourceFile(const char * code, size_t size, size_t offset, size_t removed, const char * inserted, size_t inserted_size, std::vector<char> && buffer = std::vector<char>());
+
+		SourceFile(SourceFile &&) = default;
+
+		/// Returns the buffer given to the constructor, so that it can be reused to load another file.
+		std::vector<char> ReleaseBuffer() {
+			return std::move(buffer);
+		}
+
+		/// Returns the (null-terminated) contents of the file.
+		const char * Data() const {
+			return (mapped_file.is_open()) ? mapped_file.const_data() : buffer.data();
+		}
+
+		/// Returns the size of the file (excluding the null terminator).
+		size_t Size() const {
+			return size;
+		}
+
+		/// Returns whether the file is memory mapped.
+		bool MemoryMapped() const {
+			return mapped_file.is_open();
+		}
+	};
+}
+
+#endif // CPPX_SOURCE_FILE_H
@@ -0,0 +1,174 @@
+/*
+	Noel Lopes is a Professor at the Polytechnic of Guarda, Portugal
+	and a Researcher at the CISUC - University of Coimbra, Portugal
+	Copyright (C) 2017 Noel de Jesus Mendonça Lopes
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+#include <algorithm>
+#include <iomanip>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "json.h"
+#include "statistics.h"
+
+#ifdef BOOST_POSIX_API
+	#include <sys/resource.h>
+#elif defined(_WIN32)
+	#include <windows.h>
+	#include <psapi.h>
+#endif
+
+namespace cppx {
+	namespace {
+		const char * PHASE_NAMES[] = { "discovery", "load", "parse", "generate", "write" };
+		const char * COUNTER_NAMES[] = { "files_processed", "files_up_to_date", "files_with_errors", "bytes_in", "bytes_out", "code_blocks", "outputs_written", "outputs_unchanged", "memory_waits" };
+
+		std::mutex files_mutex;
+		std::vector<std::pair<std::chrono::steady_clock::duration, std::string>> files;
+
+		double Seconds(std::chrono::steady_clock::duration duration) {
+			return std::chrono::duration<double>(duration).count();
+		}
+
+		double Seconds(uint64_t nanoseconds) {
+			return nanoseconds / 1e9;
+		}
+
+		std::vector<std::pair<std::chrono::steady_clock::duration, std::string>> SlowestFiles(size_t number_files) {
+			std::lock_guard<std::mutex> lock(files_mutex);
+
+			auto slowest = files;
+			number_files = std::min(number_files, slowest.size());
+
+			std::partial_sort(slowest.begin(), slowest.begin() + number_files, slowest.end(), [] (const std::pair<std::chrono::steady_clock::duration, std::string> & a, const std::pair<std::chrono::steady_clock::duration, std::string> & b) {
+				return a.first > b.first;
+			});
+
+			slowest.resize(number_files);
+			return slowest;
+		}
+	}
+
+	bool Statistics::enabled = false;
+	std::atomic<uint64_t> Statistics::phase_nanoseconds[static_cast<size_t>(Phase::total)];
+	std::atomic<uint64_t> Statistics::counters[static_cast<size_t>(Counter::total)];
+
+	void Statistics::Enable() {
+		for (auto & p : phase_nanoseconds) p = 0;
+		for (auto & c : counters) c = 0;
+
+		enabled = true;
+	}
+
+	void Statistics::AddTime(Phase phase, std::chrono::steady_clock::duration duration) {
+		uint64_t nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+		phase_nanoseconds[static_cast<size_t>(phase)].fetch_add(nanoseconds, std::memory_order_relaxed);
+	}
+
+	void Statistics::RecordFile(const boost::filesystem::path & filename, std::chrono::steady_clock::duration duration) {
+		std::lock_guard<std::mutex> lock(files_mutex);
+		files.push_back(std::make_pair(duration, filename.string()));
+	}
+
+	size_t Statistics::PeakMemoryUsage() {
+		#ifdef BOOST_POSIX_API
+			struct rusage usage;
+			if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+
+			#ifdef __APPLE__
+				return static_cast<size_t>(usage.ru_maxrss); // bytes
+			#else
+				return static_cast<size_t>(usage.ru_maxrss) * 1024; // kilobytes
+			#endif
+		#elif defined(_WIN32)
+			PROCESS_MEMORY_COUNTERS counters;
+			if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+
+			return counters.PeakWorkingSetSize;
+		#else
+			return 0;
+		#endif
+	}
+
+	void Statistics::Print(std::ostream & os, std::chrono::steady_clock::duration wall_time, size_t number_slowest_files) {
+		os << "Statistics:" << std::endl;
+		os << std::fixed << std::setprecision(3);
+		os << "  wall time: " << 1000 * Seconds(wall_time) << " ms" << std::endl;
+
+		os << "  time per phase (summed over all threads):" << std::endl;
+		for (size_t p = 0; p < static_cast<size_t>(Phase::total); ++p) {
+			os << "    " << std::left << std::setw(20) << PHASE_NAMES[p] << std::right << std::setw(12) << 1000 * Seconds(phase_nanoseconds[p].load()) << " ms" << std::endl;
+		}
+
+		for (size_t c = 0; c < static_cast<size_t>(Counter::total); ++c) {
+			os << "  " << std::left << std::setw(22) << COUNTER_NAMES[c] << std::right << std::setw(12) << counters[c].load() << std::endl;
+		}
+
+		os << "  " << std::left << std::setw(22) << "peak_memory_usage" << std::right << std::setw(12) << PeakMemoryUsage() << std::endl;
+
+		auto slowest = SlowestFiles(number_slowest_files);
+
+		if (!slowest.empty()) {
+			os << "  slowest files:" << std::endl;
+			for (const auto & f : slowest) os << "    " << std::setw(12) << 1000 * Seconds(f.first) << " ms  " << f.second << std::endl;
+		}
+
+		os.unsetf(std::ios_base::floatfield);
+	}
+
+	void Statistics::PrintSummary(std::ostream & os, std::chrono::steady_clock::duration wall_time) {
+		auto Count = [] (Counter counter) {
+			return counters[static_cast<size_t>(counter)].load();
+		};
+
+		uint64_t processed = Count(Counter::files_processed);
+		uint64_t up_to_date = Count(Counter::files_up_to_date);
+		uint64_t errors = Count(Counter::files_with_errors);
+
+		os << (processed + up_to_date) << " files: " << (processed - errors) << " generated, " << up_to_date << " up to date, " << errors << " with errors (";
+		os << std::fixed << std::setprecision(3) << Seconds(wall_time) << " s)" << std::endl;
+		os.unsetf(std::ios_base::floatfield);
+	}
+
+	void Statistics::PrintJson(std::ostream & os, std::chrono::steady_clock::duration wall_time, size_t number_slowest_files) {
+		os << std::setprecision(9);
+		os << "{\n";
+		os << "\t\"wall_time_seconds\": " << Seconds(wall_time) << ",\n";
+
+		os << "\t\"phase_seconds\": {";
+		for (size_t p = 0; p < static_cast<size_t>(Phase::total); ++p) {
+			os << ((p == 0) ? " " : ", ") << '"' << PHASE_NAMES[p] << "\": " << Seconds(phase_nanoseconds[p].load());
+		}
+		os << " },\n";
+
+		for (size_t c = 0; c < static_cast<size_t>(Counter::total); ++c) {
+			os << "\t\"" << COUNTER_NAMES[c] << "\": " << counters[c].load() << ",\n";
+		}
+
+		os << "\t\"peak_memory_usage\": " << PeakMemoryUsage() << ",\n";
+
+		auto slowest = SlowestFiles(number_slowest_files);
+
+		os << "\t\"slowest_files\": [";
+		for (size_t f = 0; f < slowest.size(); ++f) {
+			os << ((f == 0) ? "\n" : ",\n") << "\t\t{ \"file\": " << JsonString(slowest[f].second) << ", \"seconds\": " << Seconds(slowest[f].first) << " }";
+		}
+		os << (slowest.empty() ? "]\n" : "\n\t]\n");
+
+		os << "}\n";
+	}
+}
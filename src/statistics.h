@@ -0,0 +1,153 @@
+/*
+	Noel Lopes is a Professor at the Polytechnic of Guarda, Portugal
+	and a Researcher at the CISUC - University of Coimbra, Portugal
+	Copyright (C) 2017 Noel de Jesus Mendonça Lopes
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+#ifndef CPPX_STATISTICS_H
+#define CPPX_STATISTICS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#include <boost/filesystem.hpp>
+
+namespace cppx {
+
+	/// Collects statistics about a cppxgen run (time spent in each phase, 
+	/// bytes read and written, number of code blocks and slowest files).
+	/// Statistics are only collected after Enable is called. Otherwise, 
+	/// each instrumentation point costs a single test of a boolean flag.
+	/// Can be safely used by several threads.
+	class Statistics {
+	public:
+		enum class Phase {
+			discovery, // Obtaining the files to process (GetFilesToProcess)
+			load,      // Mapping the files into memory
+			parse,     // Tokenizing (Parser)
+			generate,  // Generating the .h and .cpp code
+			write,     // Comparing and writing the .h and .cpp files
+			total
+		};
+
+		enum class Counter {
+			files_processed,
+			files_up_to_date,
+			files_with_errors,
+			bytes_in,
+			bytes_out,
+			code_blocks,
+			outputs_written,
+			outputs_unchanged,
+			memory_waits, // times that workers backed off, waiting for memory (see MemoryBudget)
+			total
+		};
+
+		/// Measures the time spent in a phase, from its creation until its destruction.
+		class Timer {
+		private:
+			Phase phase;
+			bool active;
+			std::chrono::steady_clock::time_point start;
+
+		public:
+			explicit Timer(Phase phase) : phase(phase), active(enabled) {
+				if (active) start = std::chrono::steady_clock::now();
+			}
+
+			Timer(const Timer &) = delete;
+			Timer & operator = (const Timer &) = delete;
+
+			~Timer() {
+				Stop();
+			}
+
+			/// Stops measuring the time (before the timer is destroyed).
+			void Stop() {
+				if (active) {
+					AddTime(phase, std::chrono::steady_clock::now() - start);
+					active = false;
+				}
+			}
+		};
+
+	private:
+		static bool enabled;
+		static std::atomic<uint64_t> phase_nanoseconds[static_cast<size_t>(Phase::total)];
+		static std::atomic<uint64_t> counters[static_cast<size_t>(Counter::total)];
+
+		static void AddTime(Phase phase, std::chrono::steady_clock::duration duration);
+		static void RecordFile(const boost::filesystem::path & filename, std::chrono::steady_clock::duration duration);
+
+	public:
+		/// Starts collecting statistics. Must be called before any other thread uses the statistics.
+		static void Enable();
+
+		static bool Enabled() {
+			return enabled;
+		}
+
+		/// Adds \a value to a counter.
+		static void Add(Counter counter, uint64_t value = 1) {
+			if (enabled) counters[static_cast<size_t>(counter)].fetch_add(value, std::memory_order_relaxed);
+		}
+
+		/// Measures the time spent processing a file (used to find the slowest files).
+		class FileTimer {
+		private:
+			const boost::filesystem::path & filename;
+			bool active;
+			std::chrono::steady_clock::time_point start;
+
+		public:
+			explicit FileTimer(const boost::filesystem::path & filename) : filename(filename), active(enabled) {
+				if (active) start = std::chrono::steady_clock::now();
+			}
+
+			FileTimer(const FileTimer &) = delete;
+			FileTimer & operator = (const FileTimer &) = delete;
+
+			~FileTimer() {
+				if (active) RecordFile(filename, std::chrono::steady_clock::now() - start);
+			}
+		};
+
+		/// Returns the peak resident set size of the process (in bytes) or 0 if it is not available.
+		/// Unlike the other statistics, it is available even if the statistics were not enabled.
+		static size_t PeakMemoryUsage();
+
+		/// Outputs the statistics in a human readable form.
+		/// \param os Output stream.
+		/// \param wall_time Wall time of the whole run.
+		/// \param number_slowest_files Number of slowest files to list.
+		static void Print(std::ostream & os, std::chrono::steady_clock::duration wall_time, size_t number_slowest_files);
+
+		/// Outputs a single line with the totals of the run (number of files processed, up to date and with errors).
+		/// \param os Output stream.
+		/// \param wall_time Wall time of the whole run.
+		static void PrintSummary(std::ostream & os, std::chrono::steady_clock::duration wall_time);
+
+		/// Outputs the statistics in JSON.
+		/// \param os Output stream.
+		/// \param wall_time Wall time of the whole run.
+		/// \param number_slowest_files Number of slowest files to list.
+		static void PrintJson(std::ostream & os, std::chrono::steady_clock::duration wall_time, size_t number_slowest_files);
+	};
+}
+
+#endif // CPPX_STATISTICS_H
@@ -0,0 +1,163 @@
+/*
+	Noel Lopes is a Professor at the Polytechnic of Guarda, Portugal
+	and a Researcher at the CISUC - University of Coimbra, Portugal
+	Copyright (C) 2017 Noel de Jesus Mendonça Lopes
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+#include <algorithm>
+#include <fstream>
+#include <set>
+
+#include "console.h"
+#include "hash.h"
+#include "output_file.h"
+#include "unity_build.h"
+
+namespace cppx {
+	namespace {
+		// First line of the unity files, used to make sure that only unity files are removed
+		const char * UNITY_FILE_MARKER = "// Unity build file generated by cppxgen. Do not edit.";
+
+		constexpr size_t MAX_UNIT_SIZE_FACTOR = 4;
+
+		bool IsUnityFile(const boost::filesystem::path & filename) {
+			std::ifstream file(filename.string());
+			std::string line;
+
+			return std::getline(file, line) && line == UNITY_FILE_MARKER;
+		}
+
+		// Returns the path of filename relative to base_dir (which the manifest stores, so that it does not depend on the current directory)
+		std::string RelativePath(const boost::filesystem::path & base_dir, const boost::filesystem::path & filename) {
+			std::string base = base_dir.generic_string();
+			std::string file = filename.generic_string();
+
+			if (file.compare(0, base.size(), base) != 0) return file;
+
+			size_t begin = base.size();
+			while (begin < file.size() && file[begin] == '/') ++begin;
+
+			return file.substr(begin);
+		}
+
+		std::set<std::string> ReadManifest(const boost::filesystem::path & manifest) {
+			std::set<std::string> filenames;
+
+			std::ifstream file(manifest.string());
+
+			for (std::string line; std::getline(file, line);) {
+				if (!line.empty()) filenames.insert(line);
+			}
+
+			return filenames;
+		}
+	}
+
+	std::vector<UnityFile> GroupUnityFiles(std::vector<boost::filesystem::path> sources, size_t files_per_unit) {
+		if (files_per_unit == 0) files_per_unit = 1;
+
+		std::sort(sources.begin(), sources.end());
+
+		std::vector<UnityFile> units;
+
+		for (const auto & source : sources) {
+			bool begins_unit = units.empty() || units.back().filename.parent_path() != source.parent_path() 
+				|| Hash(source.filename().string()) % files_per_unit == 0 
+				|| units.back().sources.size() >= MAX_UNIT_SIZE_FACTOR * files_per_unit;
+
+			if (begins_unit) {
+				UnityFile unit;
+				unit.filename = source.parent_path() / (source.stem().string() + ".unity.cpp");
+
+				units.push_back(unit);
+			}
+
+			units.back().sources.push_back(source);
+		}
+
+		std::sort(units.begin(), units.end(), [] (const UnityFile & a, const UnityFile & b) {
+			return a.filename < b.filename;
+		});
+
+		return units;
+	}
+
+	bool WriteUnityBuild(const boost::filesystem::path & base_dir, const std::vector<boost::filesystem::path> & files, size_t files_per_unit) {
+		using namespace boost::filesystem;
+
+		bool success = true;
+
+		std::vector<path> sources;
+
+		for (const auto & f : files) {
+			path source = f;
+			source.replace_extension(".cpp");
+
+			boost::system::error_code error;
+			if (is_regular_file(source, error)) sources.push_back(source);
+		}
+
+		std::vector<UnityFile> units = GroupUnityFiles(sources, files_per_unit);
+
+		std::string manifest_contents;
+		std::set<std::string> written;
+
+		for (const auto & unit : units) {
+			std::string contents = UNITY_FILE_MARKER;
+			contents += "\n\n";
+
+			for (const auto & source : unit.sources) {
+				contents.append("#include \"").append(source.filename().string()).append("\"\n");
+			}
+
+			try {
+				WriteFileIfChanged(unit.filename, contents);
+			} catch (const filesystem_error & exception) {
+				Console::ErrorStream() << "Could not write the unity build file " << unit.filename << ": " << exception.what() << std::endl;
+				success = false;
+			}
+
+			std::string relative_path = RelativePath(base_dir, unit.filename);
+
+			written.insert(relative_path);
+			manifest_contents.append(relative_path).append("\n");
+		}
+
+		path manifest = base_dir / UNITY_MANIFEST_FILENAME;
+
+		// Unity files of previous runs that are no longer needed
+		for (const auto & relative_path : ReadManifest(manifest)) {
+			path filename = base_dir / relative_path;
+			if (written.count(relative_path) != 0 || !IsUnityFile(filename)) continue;
+
+			boost::system::error_code error;
+			remove(filename, error);
+
+			if (error) {
+				Console::ErrorStream() << "Could not remove the unity build file " << filename << ": " << error.message() << std::endl;
+				success = false;
+			}
+		}
+
+		try {
+			WriteFileIfChanged(manifest, manifest_contents);
+		} catch (const filesystem_error & exception) {
+			Console::ErrorStream() << "Could not write the unity build manifest: " << exception.what() << std::endl;
+			success = false;
+		}
+
+		return success;
+	}
+}
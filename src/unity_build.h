@@ -0,0 +1,60 @@
+/*
+	Noel Lopes is a Professor at the Polytechnic of Guarda, Portugal
+	and a Researcher at the CISUC - University of Coimbra, Portugal
+	Copyright (C) 2017 Noel de Jesus Mendonça Lopes
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+#ifndef CPPX_UNITY_BUILD_H
+#define CPPX_UNITY_BUILD_H
+
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+namespace cppx {
+
+	/// Unity (jumbo) build file, which includes several generated source files (.cpp), 
+	/// so that the headers they have in common are only parsed once by the compiler.
+	struct UnityFile {
+		boost::filesystem::path filename;
+		std::vector<boost::filesystem::path> sources; // generated source files (.cpp), in the same directory
+	};
+
+	/// Name of the file (in the base directory) that records the unity build files written by WriteUnityBuild.
+	constexpr const char * UNITY_MANIFEST_FILENAME = ".cppxunity";
+
+	/// Groups the source files of each directory into unity build files. The groups are 
+	/// deterministic and stable: each group begins at a file whose name hash is a multiple 
+	/// of \a files_per_unit (or when the group reaches 4 times that number of files), so that 
+	/// adding or removing a file only changes its own group (instead of all the following ones).
+	/// Each unity file is named after the first source file of its group (<name>.unity.cpp).
+	/// \param sources Generated source files (.cpp).
+	/// \param files_per_unit Average number of source files per unity file (at least one).
+	/// \return The unity files, sorted by filename.
+	std::vector<UnityFile> GroupUnityFiles(std::vector<boost::filesystem::path> sources, size_t files_per_unit);
+
+	/// Writes the unity build files of the source files generated from the given extended 
+	/// C++ files (.cppx), skipping those whose source file does not exist. Unity files are 
+	/// only written when their contents change. Those written by previous runs that are 
+	/// no longer needed are removed (see UNITY_MANIFEST_FILENAME).
+	/// \param base_dir Base directory of the extended C++ files.
+	/// \param files Extended C++ files (.cppx).
+	/// \param files_per_unit Average number of source files per unity file (see GroupUnityFiles).
+	/// \return false if any of the files could not be written (or removed).
+	bool WriteUnityBuild(const boost::filesystem::path & base_dir, const std::vector<boost::filesystem::path> & files, size_t files_per_unit);
+}
+
+#endif // CPPX_UNITY_BUILD_H
@@ -0,0 +1,117 @@
+/*
+	Noel Lopes is a Professor at the Polytechnic of Guarda, Portugal
+	and a Researcher at the CISUC - University of Coimbra, Portugal
+	Copyright (C) 2017 Noel de Jesus Mendonça Lopes
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+#ifndef CPPX_WORK_STEALING_POOL_H
+#define CPPX_WORK_STEALING_POOL_H
+
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cppx {
+
+	/// Processes a set of independent tasks using a pool of worker threads.
+	/// Tasks are dealt (in order) to the queues of the workers. Each worker
+	/// processes the tasks at the front of its own queue and, once it is
+	/// empty, steals tasks from the back of the queues of the other workers.
+	/// \tparam Task Type of the tasks.
+	template <typename Task>
+	class WorkStealingPool {
+	private:
+		struct Queue {
+			std::mutex mutex;
+			std::deque<Task> tasks;
+		};
+
+		std::vector<Queue> queues;
+
+		bool PopFront(size_t worker, Task & task) {
+			Queue & queue = queues[worker];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+
+			if (queue.tasks.empty()) return false;
+
+			task = std::move(queue.tasks.front());
+			queue.tasks.pop_front();
+
+			return true;
+		}
+
+		bool Steal(size_t worker, Task & task) {
+			for (size_t i = 1; i < queues.size(); ++i) {
+				Queue & queue = queues[(worker + i) % queues.size()];
+				std::lock_guard<std::mutex> lock(queue.mutex);
+
+				if (!queue.tasks.empty()) {
+					task = std::move(queue.tasks.back());
+					queue.tasks.pop_back();
+
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		template <typename Function>
+		void Work(size_t worker, Function & process) {
+			Task task;
+
+			while (PopFront(worker, task) || Steal(worker, task)) {
+				process(task, worker);
+			}
+		}
+
+	public:
+		/// Creates a pool.
+		/// \param number_workers Number of worker threads (at least one).
+		explicit WorkStealingPool(size_t number_workers) : queues((number_workers == 0) ? 1 : number_workers) {}
+
+		WorkStealingPool(const WorkStealingPool &) = delete;
+		WorkStealingPool & operator = (const WorkStealingPool &) = delete;
+
+		size_t NumberWorkers() const {
+			return queues.size();
+		}
+
+		/// Processes the given tasks, returning after all of them have been processed.
+		/// When the pool has a single worker, the tasks are processed by the calling thread.
+		/// \param tasks Tasks to process. Tasks at the front are (generally) processed first.
+		/// \param process Function called (concurrently) to process each task. It receives 
+		///        the task and the index of the worker (less than NumberWorkers()) processing it.
+		template <typename Function>
+		void Run(const std::vector<Task> & tasks, Function process) {
+			for (size_t t = 0; t < tasks.size(); ++t) {
+				queues[t % queues.size()].tasks.push_back(tasks[t]);
+			}
+
+			std::vector<std::thread> workers;
+
+			for (size_t w = 1; w < queues.size(); ++w) {
+				workers.push_back(std::thread([this, w, &process] { Work(w, process); }));
+			}
+
+			Work(0, process);
+
+			for (auto & worker : workers) worker.join();
+		}
+	};
+}
+
+#endif // CPPX_WORK_STEALING_POOL_H